@@ -5,7 +5,17 @@ include $(CLEAR_VARS)
 LOCAL_FORCE_STATIC_EXECUTABLE := true
 
 LOCAL_SRC_FILES:= \
-    lcdparamservice.c
+    lcdparamservice.c \
+    lcdparam.c \
+    lcdparam_check.c \
+    lcdparam_catalog.c \
+    lcdparam_cvt.c \
+    lcdparam_pll.c \
+    lcdparam_dsi.c \
+    lcdparam_edp.c \
+    lcdparam_edid.c \
+    lcdparam_seq.c \
+    lcdparam_logo.c
 
 LOCAL_C_INCLUDES += bionic \
 $(call include-path-for, libhardware_legacy)/hardware_legacy
@@ -14,8 +24,52 @@ LOCAL_MODULE:=lcdparamservice
 
 LOCAL_MODULE_TAGS := optional
 
-LOCAL_STATIC_LIBRARIES := libfs_mgr libcutils libc liblog
+LOCAL_STATIC_LIBRARIES := libfs_mgr libcutils libc libm liblog
 
 LOCAL_SHARED_LIBRARIES := libhardware_legacy libnetutils liblog
 
 include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+    lcdparamtool.c \
+    lcdparam.c \
+    lcdparam_check.c \
+    lcdparam_catalog.c \
+    lcdparam_cvt.c \
+    lcdparam_pll.c \
+    lcdparam_dsi.c \
+    lcdparam_edp.c \
+    lcdparam_edid.c \
+    lcdparam_seq.c \
+    lcdparam_logo.c
+
+LOCAL_CFLAGS += -DLCDPARAM_HOST
+LOCAL_LDLIBS += -lm
+
+LOCAL_MODULE:=lcdparamtool
+
+LOCAL_MODULE_TAGS := optional
+
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+    lcdparambench.c \
+    ../u-boot/drivers/video/rockchip_phandle.c \
+    ../u-boot/drivers/video/rockchip_bmp.c
+
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../u-boot/drivers/video \
+    external/dtc/libfdt
+
+LOCAL_CFLAGS += -DUSE_HOSTCC
+
+LOCAL_STATIC_LIBRARIES := libfdt
+
+LOCAL_MODULE:=lcdparambench
+
+LOCAL_MODULE_TAGS := optional
+
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,536 @@
+/*********************************************************************************
+* Copyright 2019 Bob Shen
+* FileName: lcdparam.c
+* Author: Bob Shen
+* Version: 1.0.0
+* Date: 2019-3-14
+* Description:
+*     Parse the lcd_parameters file into the lcdparam partition blob.
+*
+* Revision:
+*     Date:
+*     Reviser:
+*     Description:
+*********************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <libgen.h>
+
+#include "lcdparam.h"
+
+char *key[CONFIG_MAX] = {
+    "panel-type",  //1
+
+    "unprepare-delay-ms",
+    "enable-delay-ms",
+    "disable-delay-ms",
+    "prepare-delay-ms",
+    "reset-delay-ms",
+    "init-delay-ms",
+    "width-mm",
+    "height-mm",
+
+    "clock-frequency", //10
+    "hactive",
+    "hfront-porch",
+    "hsync-len",
+    "hback-porch",
+    "vactive",
+    "vfront-porch",
+    "vsync-len",
+    "vback-porch",
+    "hsync-active",
+    "vsync-active", // 20
+    "de-active",
+    "pixelclk-active",
+
+    "uboot-init",
+
+    "lvds,format",
+    "lvds,mode",
+    "lvds,width",
+    "lvds,channel",
+
+    "dsi,lane-rate",
+    "dsi,flags",
+    "dsi,format",
+    "dsi,lanes",
+
+    "orientation",
+    "density",
+
+    "panel-init-sequence",
+
+    "edp,link-rate",
+    "edp,lanes",
+    "edp,bpc",
+
+    "logo,format"
+};
+
+static uint32 crc32_tab[256];
+
+int key2Index(char *k)
+{
+    int i;
+
+    for (i = 0; i < CONFIG_MAX; i++) {
+        if (strstr(k, key[i])) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+* @decs: 获取key在lcdparam分区中的偏移
+* @param: index
+* @return: 字节偏移
+*/
+int lcdparam_offset(int index)
+{
+    if (index >= LCDPARAM_EXT_FIRST) {
+        return LCDPARAM_EXT_OFFSET + (index - LCDPARAM_EXT_FIRST) * 4;
+    }
+
+    return index * 4;
+}
+
+static uint32 get_be32(const uint8 *p)
+{
+    uint32 value;
+
+    value = p[0];
+    value = (value << 8) + p[1];
+    value = (value << 8) + p[2];
+    value = (value << 8) + p[3];
+
+    return value;
+}
+
+static void put_be32(uint8 *p, uint32 value)
+{
+    p[0] = (uint8)(value >> 24);
+    p[1] = (uint8)(value >> 16);
+    p[2] = (uint8)(value >> 8);
+    p[3] = (uint8)(value >> 0);
+}
+
+uint32 lcdparam_get(const uint8 *data, int index)
+{
+    return get_be32(data + lcdparam_offset(index));
+}
+
+void lcdparam_set(uint8 *data, int index, uint32 value)
+{
+    put_be32(data + lcdparam_offset(index), value);
+}
+
+uint32 lcdparam_get_crc(const uint8 *data)
+{
+    return get_be32(data + LCDPARAM_CRC_OFFSET);
+}
+
+void lcdparam_set_crc(uint8 *data, uint32 crc)
+{
+    put_be32(data + LCDPARAM_CRC_OFFSET, crc);
+}
+
+static void init_crc32_tab(void)
+{
+    int i = 0;
+    int j = 0;
+    uint32 crc = 0;
+
+    for (i = 0; i < 256; i++) {
+        crc = (uint32)i;
+        for (j = 0; j < 8; j++) {
+            if (crc & 0x00000001L) {
+                crc = (crc >> 1) ^ CRC_POLY;
+            } else {
+                crc = crc >> 1;
+            }
+        }
+        crc32_tab[i] = crc;
+    }
+}
+
+uint32 get_crc32(uint32 crc_init, uint8 *crc_buf, uint32 buf_size)
+{
+    uint32 crc = crc_init ^ 0xffffffff;
+
+    init_crc32_tab();
+    while (buf_size--) {
+        crc = (crc >> 8) ^ crc32_tab[(crc & 0xff) ^ *crc_buf++];
+    }
+    return crc ^ 0xfffffff;
+}
+
+uint32 getfile_crc(FILE *fp)
+{
+    uint32 size = 4 * 1024;
+    uint8 crc_buf[size];
+    uint32 readln = 0;
+    uint32 crc = 0;
+
+    while ((readln = fread(crc_buf, sizeof(uint8), size, fp)) > 0) {
+        crc = get_crc32(crc, crc_buf, readln);
+    }
+
+    return crc;
+}
+
+/**
+* @decs:去除字符串左端空格
+* @param: pstr
+* @return: char *
+*/
+static char *strtriml(char *pstr)
+{
+    int i = 0, j;
+    j = strlen(pstr) - 1;
+    while (isspace(pstr[i]) && (i <= j)) {
+        i++;
+    }
+    if (0 < i) {
+        memmove(pstr, &pstr[i], strlen(&pstr[i]) + 1);
+    }
+    return pstr;
+}
+
+/**
+* @decs:去除字符串右端空格
+* @param: pstr
+* @return: char *
+*/
+static char *strtrimr(char *pstr)
+{
+    int i;
+    i = strlen(pstr) - 1;
+    while ((i >= 0) && isspace(pstr[i])) {
+        pstr[i--] = '\0';
+    }
+    return pstr;
+}
+
+/**
+* @decs:去除字符串两端空格
+* @param: pstr
+* @return: char *
+*/
+char *strtrim(char *pstr)
+{
+    char *p;
+    p = strtrimr(pstr);
+    return strtriml(p);
+}
+
+char *strdelchr(char *pstr, int chr)
+{
+    int i = 0;
+    int l = 0;
+    int ll = 0;
+    ll = l = strlen(pstr);
+
+    while (i < l) {
+        if (pstr[i] == chr) {
+            memmove((pstr + i), (pstr + i + 1), (ll - i - 1));
+            pstr[ll - 1] = '\0';
+            ll--;
+        }
+        i++;
+    }
+    return pstr;
+}
+
+void strrmspace(char *str)
+{
+    char *p1, *p2;
+    char ch;
+    p1 = str; //first pointer
+    p2 = str; //second pointer to the remaining string
+
+    if (p1 == NULL) {
+        return;
+    }
+
+    while (*p1) {
+        if (*p1 != ' ') {
+            ch = *p1;
+            *p2 = ch;
+            p1++;
+            p2++;
+        } else {
+            p1++;
+        }
+    }
+    *p2 = '\0';
+}
+
+/**
+* @decs: 解析panel-init-sequence的十六进制字符串
+* @param: data, val
+* @return: 0：success <0: failed
+*/
+static int parse_init_sequence(uint8 *data, char *val)
+{
+    char cmd[5] = {'\0'};
+    int cmdlen = strlen(val) / 2;
+    int count = 0;
+
+    if (cmdlen > LCDPARAM_SEQ_MAX_LEN) {
+        LCDPARAM_LOGE("panel-init-sequence is %d bytes, max %d", cmdlen, LCDPARAM_SEQ_MAX_LEN);
+        return -1;
+    }
+
+    lcdparam_set(data, LCDPARAM_INIT_SEQUENCE, cmdlen);
+
+    for (count = 0; count < cmdlen; count++) {
+        cmd[0] = '0';
+        cmd[1] = 'x';
+        cmd[2] = val[count * 2];
+        cmd[3] = val[count * 2 + 1];
+        data[LCDPARAM_SEQ_OFFSET + count] = (uint8)strtol(cmd, NULL, 16);
+    }
+
+    return 0;
+}
+
+/**
+* @decs: 解析init-sequence-min-delay, 如"11:120 29:20 *:0", 命令为十六进制, 延时单位ms
+* @param: val, opts
+* @return: 1：success <0: failed
+*/
+static int parse_seq_min_delay(const char *val, struct lcdparam_options *opts)
+{
+    char buf[256];
+    char *item, *save = NULL;
+    unsigned int cmd, delay;
+
+    strncpy(buf, val, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+
+    for (item = strtok_r(buf, " ,", &save); item; item = strtok_r(NULL, " ,", &save)) {
+        if (sscanf(item, "*:%u", &delay) == 1 && delay <= 255) {
+            opts->seq_min_default = delay;
+        } else if (sscanf(item, "%x:%u", &cmd, &delay) == 2 && cmd <= 0xff && delay <= 255
+                   && opts->seq_min_count < LCDPARAM_SEQ_MIN_MAX) {
+            opts->seq_min_cmd[opts->seq_min_count] = cmd;
+            opts->seq_min_delay[opts->seq_min_count] = delay;
+            opts->seq_min_count++;
+        } else {
+            LCDPARAM_LOGE("init-sequence-min-delay: bad entry %s, must be like 11:120 or *:0", item);
+            return -1;
+        }
+    }
+
+    return 1;
+}
+
+/**
+* @decs: 解析lcd_parameters文件中不写入分区的指令
+* @param: name, val, opts
+* @return: 1：是指令 0：不是指令 <0: 指令错误
+*/
+static int parse_option(const char *name, const char *val, struct lcdparam_options *opts)
+{
+    char method[16] = "cvt";
+
+    if (!strcmp(name, "profile")) {
+        strncpy(opts->profile, val, sizeof(opts->profile) - 1);
+        return 1;
+    } else if (!strcmp(name, "edid")) {
+        strncpy(opts->edid, val, sizeof(opts->edid) - 1);
+        return 1;
+    } else if (!strcmp(name, "mode")) {
+        if (sscanf(val, "%dx%d@%d %15s", &opts->mode_hactive, &opts->mode_vactive,
+                   &opts->mode_vrefresh, method) < 3
+            || (strcmp(method, "cvt") && strcmp(method, "cvt-rb"))) {
+            LCDPARAM_LOGE("mode = %s, must be like 1920x1080@60 cvt | cvt-rb", val);
+            return -1;
+        }
+        opts->mode_reduced = !strcmp(method, "cvt-rb");
+        return 1;
+    } else if (!strcmp(name, "dclk-pll")) {
+        static const char *plls[] = { "none", "npll", "gpll", "cpll" };
+        int i;
+
+        for (i = 0; i < (int)(sizeof(plls) / sizeof(plls[0])); i++) {
+            if (!strcmp(val, plls[i])) {
+                opts->dclk_pll = i;
+                return 1;
+            }
+        }
+        LCDPARAM_LOGE("dclk-pll = %s, must be npll | gpll | cpll | none", val);
+        return -1;
+    } else if (!strcmp(name, "refresh-mhz")) {
+        opts->refresh_mhz = atoi(val);
+        return 1;
+    } else if (!strcmp(name, "refresh-tolerance-ppm")) {
+        opts->refresh_tolerance_ppm = atoi(val);
+        return 1;
+    } else if (!strcmp(name, "dsi,lane-rate-headroom")) {
+        opts->lane_rate_headroom = atoi(val);
+        return 1;
+    } else if (!strcmp(name, "init-sequence-mode")) {
+        if (!strcmp(val, "verbatim")) {
+            opts->seq_mode = LCDPARAM_SEQ_VERBATIM;
+        } else if (!strcmp(val, "optimize")) {
+            opts->seq_mode = LCDPARAM_SEQ_OPTIMIZE;
+        } else {
+            LCDPARAM_LOGE("init-sequence-mode = %s, must be verbatim | optimize", val);
+            return -1;
+        }
+        return 1;
+    } else if (!strcmp(name, "init-sequence-min-delay")) {
+        return parse_seq_min_delay(val, opts);
+    }
+
+    return 0;
+}
+
+/**
+* @decs: 读取lcd_parameters引用的EDID文件, 相对路径以lcd_parameters所在目录为准
+* @param: path, edid, data
+* @return: 0：success <0: failed
+*/
+static int load_edid(const char *path, const char *edid, uint8 *data)
+{
+    char dir[256], file[512];
+    FILE *fp;
+    int ret;
+
+    if (edid[0] == '/' || path == NULL) {
+        snprintf(file, sizeof(file), "%s", edid);
+    } else {
+        strncpy(dir, path, sizeof(dir) - 1);
+        dir[sizeof(dir) - 1] = '\0';
+        snprintf(file, sizeof(file), "%s/%s", dirname(dir), edid);
+    }
+
+    fp = fopen(file, "rb");
+    if (fp == NULL) {
+        LCDPARAM_LOGE("edid = %s, open %s failed", edid, file);
+        return -1;
+    }
+    ret = lcdparam_edid_read(fp, data);
+    fclose(fp);
+
+    return ret;
+}
+
+/**
+* @decs: 解析lcd_parameters文件，生成lcdparam分区数据(不含crc)
+*        裸EDID文件按"panel-type = 1; edid = 该文件;"处理
+* @param: fp, path(用于解析相对路径, 可为NULL), data, opts
+* @return: 0：success <0: failed
+*/
+int lcdparam_parse(FILE *fp, const char *path, uint8 *data, struct lcdparam_options *opts)
+{
+    char line[20480] = {0};
+    char name[64];
+    uint8 magic[8];
+    int ret;
+    int i;
+
+    memset(data, '\0', LCDPARAM_STORGAE_DATA_LEN);
+    memset(opts, '\0', sizeof(*opts));
+    opts->seq_min_default = -1;
+
+    ret = fread(magic, 1, sizeof(magic), fp);
+    rewind(fp);
+    if (lcdparam_is_edid(magic, ret)) {
+        lcdparam_set(data, LCDPARAM_PANEL_TYPE, PANEL_TYPE_EDP);
+        ret = lcdparam_edid_read(fp, data);
+        if (ret < 0) {
+            return ret;
+        }
+        goto solve;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        char *p = strtrim(line);
+        char *key_val_str;
+        char *value;
+
+        if (strlen(p) <= 0 || p[0] == '#') {
+            continue;
+        }
+        if (!strstr(p, "=") && !strstr(p, ";")) {
+            continue;
+        }
+
+        // get key and value string like "screen_lvds_format = 1" spilt by ";"
+        key_val_str = strtok(p, ";");
+        if (key_val_str == NULL) {
+            continue;
+        }
+        value = strchr(key_val_str, '=');
+        if (value == NULL) {
+            continue;
+        }
+
+        snprintf(name, sizeof(name), "%.*s", (int)(value - key_val_str), key_val_str);
+        strtrim(name);
+        ret = parse_option(name, strtrim(value + 1), opts);
+        if (ret < 0) {
+            return ret;
+        } else if (ret) {
+            LCDPARAM_LOGD("%s=%s", name, value + 1);
+            continue;
+        }
+
+        for (i = 0; i < CONFIG_MAX; i++) {
+            if (strstr(key_val_str, key[i])) {
+                char *val = strdelchr(value, '=');
+                strrmspace(val);
+
+                if (i == LCDPARAM_INIT_SEQUENCE) {
+                    if (parse_init_sequence(data, val) < 0) {
+                        return -1;
+                    }
+                } else {
+                    lcdparam_set(data, i, atoi(val));
+                }
+                LCDPARAM_LOGD("%s=%s", key[i], val);
+                break;
+            }
+        }
+    }
+
+    /* the edid and then a mode line override the hand entered timing */
+    if (opts->edid[0]) {
+        ret = load_edid(path, opts->edid, data);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+    if (opts->mode_hactive) {
+        ret = lcdparam_cvt(data, opts->mode_hactive, opts->mode_vactive,
+                           opts->mode_vrefresh, opts->mode_reduced);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+solve:
+    ret = lcdparam_solve_dclk(data, opts);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = lcdparam_solve_lane_rate(data, opts);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = lcdparam_optimize_init_sequence(data, opts);
+    if (ret < 0) {
+        return ret;
+    }
+
+    return lcdparam_solve_edp_link(data);
+}
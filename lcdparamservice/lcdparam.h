@@ -0,0 +1,332 @@
+/*********************************************************************************
+* Copyright 2019 Bob Shen
+* FileName: lcdparam.h
+* Author: Bob Shen
+* Version: 1.0.0
+* Date: 2019-3-14
+* Description:
+*     Shared definitions of the lcd_parameters parser, the lcdparam partition
+*     layout and the timing validator. Used by lcdparamservice on the device
+*     and by lcdparamtool on the host.
+*
+* Revision:
+*     Date:
+*     Reviser:
+*     Description:
+*********************************************************************************/
+
+#ifndef _LCDPARAM_H
+#define _LCDPARAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef unsigned short uint16;
+typedef unsigned long uint32;
+typedef unsigned char uint8;
+
+#ifdef LCDPARAM_HOST
+#define LCDPARAM_LOGE(fmt, ...)     fprintf(stderr, "error: " fmt "\n", ##__VA_ARGS__)
+#define LCDPARAM_LOGW(fmt, ...)     fprintf(stderr, "warning: " fmt "\n", ##__VA_ARGS__)
+#define LCDPARAM_LOGI(fmt, ...)     fprintf(stdout, fmt "\n", ##__VA_ARGS__)
+#define LCDPARAM_LOGD(fmt, ...)     do { } while (0)
+#else
+#ifndef LOG_TAG
+#define LOG_TAG "LcdParamService"
+#endif
+#include <cutils/log.h>
+#define LCDPARAM_LOGE(fmt, ...)     ALOGE(fmt, ##__VA_ARGS__)
+#define LCDPARAM_LOGW(fmt, ...)     ALOGW(fmt, ##__VA_ARGS__)
+#define LCDPARAM_LOGI(fmt, ...)     ALOGI(fmt, ##__VA_ARGS__)
+#define LCDPARAM_LOGD(fmt, ...)     ALOGD(fmt, ##__VA_ARGS__)
+#endif
+
+#define LCDPARAM_STORGAE_DATA_LEN       2048 // lcdparam size
+#define LCDPARAM_CRC_OFFSET             (LCDPARAM_STORGAE_DATA_LEN - 4)
+
+#define CRC_POLY                        0xEDB88320L // CRC stand
+
+/*
+ * Index of each key in the lcdparam blob, every value is stored big endian
+ * at index * 4. The init sequence bytes follow its length word. Keys added
+ * later live in the extension area in front of the crc so that the init
+ * sequence stays where older u-boot expects it, zero means unset or auto.
+ */
+enum {
+    LCDPARAM_PANEL_TYPE = 0,
+
+    LCDPARAM_UNPREPARE_DELAY,
+    LCDPARAM_ENABLE_DELAY,
+    LCDPARAM_DISABLE_DELAY,
+    LCDPARAM_PREPARE_DELAY,
+    LCDPARAM_RESET_DELAY,
+    LCDPARAM_INIT_DELAY,
+    LCDPARAM_WIDTH_MM,
+    LCDPARAM_HEIGHT_MM,
+
+    LCDPARAM_CLOCK_FREQUENCY,
+    LCDPARAM_HACTIVE,
+    LCDPARAM_HFRONT_PORCH,
+    LCDPARAM_HSYNC_LEN,
+    LCDPARAM_HBACK_PORCH,
+    LCDPARAM_VACTIVE,
+    LCDPARAM_VFRONT_PORCH,
+    LCDPARAM_VSYNC_LEN,
+    LCDPARAM_VBACK_PORCH,
+    LCDPARAM_HSYNC_ACTIVE,
+    LCDPARAM_VSYNC_ACTIVE,
+    LCDPARAM_DE_ACTIVE,
+    LCDPARAM_PIXELCLK_ACTIVE,
+
+    LCDPARAM_UBOOT_INIT,
+
+    LCDPARAM_LVDS_FORMAT,
+    LCDPARAM_LVDS_MODE,
+    LCDPARAM_LVDS_WIDTH,
+    LCDPARAM_LVDS_CHANNEL,
+
+    LCDPARAM_DSI_LANE_RATE,
+    LCDPARAM_DSI_FLAGS,
+    LCDPARAM_DSI_FORMAT,
+    LCDPARAM_DSI_LANES,
+
+    LCDPARAM_ORIENTATION,
+    LCDPARAM_DENSITY,
+
+    LCDPARAM_INIT_SEQUENCE,
+
+    LCDPARAM_EDP_LINK_RATE,
+    LCDPARAM_EXT_FIRST = LCDPARAM_EDP_LINK_RATE,
+    LCDPARAM_EDP_LANES,
+    LCDPARAM_EDP_BPC,
+
+    LCDPARAM_LOGO_FORMAT,
+
+    CONFIG_MAX
+};
+
+#define LCDPARAM_SEQ_OFFSET             ((LCDPARAM_INIT_SEQUENCE + 1) * 4)
+#define LCDPARAM_EXT_OFFSET             1536
+#define LCDPARAM_EXT_MAX                ((LCDPARAM_CRC_OFFSET - LCDPARAM_EXT_OFFSET) / 4)
+#define LCDPARAM_SEQ_MAX_LEN            (LCDPARAM_EXT_OFFSET - LCDPARAM_SEQ_OFFSET)
+
+enum {
+    PANEL_TYPE_DSI,
+    PANEL_TYPE_EDP,
+    PANEL_TYPE_LVDS,
+};
+
+/* D-PHY lane rate range in Mbps */
+#define DSI_LANE_RATE_MIN               80
+#define DSI_LANE_RATE_MAX               1000
+#define DSI_LANE_RATE_HEADROOM          25 // %, same as the kernel dsi driver
+
+#define MIPI_DSI_MODE_VIDEO_BURST       (1 << 1)
+
+/* eDP main link rates in Mbps per lane, the rk3288 controller stops at HBR */
+#define EDP_LINK_RATE_RBR               1620
+#define EDP_LINK_RATE_HBR               2700
+#define EDP_BPC_DEFAULT                 8
+
+typedef struct {
+    unsigned char data[LCDPARAM_STORGAE_DATA_LEN];
+} LCDPARAM_STORGAE_T;
+
+/* Panel timing as seen by drm_mode_vrefresh() in u-boot */
+struct lcdparam_timing {
+    uint32 clock;               // Hz
+    int htotal;
+    int vtotal;
+    int vrefresh;               // Hz
+};
+
+#define LCDPARAM_SEQ_MIN_MAX            32
+
+/* Directives of lcd_parameters which are not stored in the blob */
+struct lcdparam_options {
+    char profile[32];
+
+    /* edid = panel.edid; relative to the lcd_parameters directory */
+    char edid[128];
+
+    /* mode = 1920x1080@60 cvt-rb; */
+    int mode_hactive;
+    int mode_vactive;
+    int mode_vrefresh;
+    int mode_reduced;
+
+    /* dclk solver */
+    int dclk_pll;
+    int refresh_mhz;
+    int refresh_tolerance_ppm;
+
+    /* dsi,lane-rate = auto; */
+    int lane_rate_headroom;
+
+    /* init-sequence-mode = optimize; init-sequence-min-delay = 11:120 *:0; */
+    int seq_mode;
+    int seq_min_count;
+    uint8 seq_min_cmd[LCDPARAM_SEQ_MIN_MAX];
+    uint8 seq_min_delay[LCDPARAM_SEQ_MIN_MAX];
+    int seq_min_default;            // -1: keep delays not in the profile
+};
+
+enum {
+    LCDPARAM_SEQ_VERBATIM,
+    LCDPARAM_SEQ_OPTIMIZE,
+};
+
+/* dclk-pll, without it clock-frequency and the porches are kept as entered */
+enum {
+    LCDPARAM_DCLK_NONE,
+    LCDPARAM_DCLK_NPLL,
+    LCDPARAM_DCLK_GPLL,
+    LCDPARAM_DCLK_CPLL,
+};
+
+/* written by u-boot only: edid and mode of each route that reads an edid */
+#define LCDPARAM_MODE_CACHE_OFFSET      0x82000
+
+/*
+ * Boot logo slot of the lcdparam partition, already at the panel resolution
+ * and in a format the vop scans out directly. All header fields are little
+ * endian u32, pixels start at data_offset from the slot.
+ */
+#define LCDPARAM_LOGO_OFFSET            0x100000 // 1MB into the partition
+#define LCDPARAM_LOGO_DATA_OFFSET       4096
+#define LCDPARAM_LOGO_MAGIC             0x4f474c4c // "LLGO"
+#define LCDPARAM_LOGO_VERSION           1
+#define LCDPARAM_LOGO_NAME              "logo.bmp"
+
+/* same values as enum data_format of the u-boot display driver */
+enum {
+    LCDPARAM_LOGO_FMT_ARGB8888 = 0,
+    LCDPARAM_LOGO_FMT_RGB888,       // b, g, r bytes
+    LCDPARAM_LOGO_FMT_RGB565,
+};
+
+/* logo,format key */
+enum {
+    LOGO_FORMAT_AUTO,
+    LOGO_FORMAT_RGB888,
+    LOGO_FORMAT_RGB565,             // error diffusion dithered
+};
+
+struct lcdparam_logo_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;                // bytes per line
+    uint32_t size;                  // bytes of pixel data
+    uint32_t data_offset;
+    uint32_t rotation;              // degrees clockwise, already applied to the pixels
+    uint32_t key;                   // source bmp and panel, to skip a rebuild
+};
+
+/* Decoded bmp, b, g, r bytes, top line first */
+struct lcdparam_image {
+    int width;
+    int height;
+    uint8 *pixels;
+};
+
+#define LCDPARAM_CATALOG_MAGIC          0x4344434c // "LCDC"
+#define LCDPARAM_CATALOG_VERSION        2
+#define LCDPARAM_CATALOG_NAME           "lcd_catalog.bin"
+#define LCDPARAM_CATALOG_BOARD_PREFIX   "board:"
+
+/*
+ * Panel catalog, many compiled profiles in one file. All fields are little
+ * endian u32, every offset is from the start of the file. Profile names and
+ * board ids are looked up through an open addressing hash index, serial
+ * number ranges are sorted by their first serial, shorter serials first and
+ * serials of the same length character by character.
+ */
+struct lcdparam_catalog_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t profile_count;
+    uint32_t bucket_count;          // power of 2
+    uint32_t serial_count;
+    uint32_t profile_offset;        // struct lcdparam_catalog_profile[profile_count]
+    uint32_t index_offset;          // struct lcdparam_catalog_bucket[bucket_count]
+    uint32_t serial_offset;         // struct lcdparam_catalog_serial[serial_count]
+    uint32_t string_offset;
+    uint32_t string_size;           // every string ends in '\0' inside it
+    uint32_t size;
+};
+
+struct lcdparam_catalog_profile {
+    uint32_t name;                  // string offset
+    uint32_t blob;                  // LCDPARAM_STORGAE_DATA_LEN bytes, crc included
+};
+
+#define LCDPARAM_CATALOG_EMPTY          0xffffffff
+
+struct lcdparam_catalog_bucket {
+    uint32_t hash;
+    uint32_t key;                   // string offset
+    uint32_t profile;               // LCDPARAM_CATALOG_EMPTY if unused
+};
+
+struct lcdparam_catalog_serial {
+    uint32_t first;                 // string offset
+    uint32_t last;                  // string offset
+    uint32_t profile;
+};
+
+struct lcdparam_catalog {
+    const uint8 *base;
+    size_t size;
+    const struct lcdparam_catalog_header *header;
+};
+
+extern char *key[CONFIG_MAX];
+
+int key2Index(char *k);
+int lcdparam_offset(int index);
+uint32 lcdparam_get(const uint8 *data, int index);
+void lcdparam_set(uint8 *data, int index, uint32 value);
+uint32 lcdparam_get_crc(const uint8 *data);
+void lcdparam_set_crc(uint8 *data, uint32 crc);
+
+uint32 get_crc32(uint32 crc_init, uint8 *crc_buf, uint32 buf_size);
+uint32 getfile_crc(FILE *fp);
+
+char *strtrim(char *pstr);
+char *strdelchr(char *pstr, int chr);
+void strrmspace(char *str);
+
+int lcdparam_parse(FILE *fp, const char *path, uint8 *data, struct lcdparam_options *opts);
+int lcdparam_get_timing(const uint8 *data, struct lcdparam_timing *timing);
+int lcdparam_check(const uint8 *data);
+int lcdparam_check_edit(const uint8 *data, int index);
+int lcdparam_cvt(uint8 *data, int hactive, int vactive, int vrefresh, int reduced);
+int lcdparam_solve_dclk(uint8 *data, const struct lcdparam_options *opts);
+int lcdparam_dsi_bpp(uint32 format);
+unsigned long long lcdparam_dsi_bandwidth(const uint8 *data);
+int lcdparam_solve_lane_rate(uint8 *data, const struct lcdparam_options *opts);
+unsigned long long lcdparam_edp_required(const uint8 *data);
+int lcdparam_edp_link_ok(const uint8 *data);
+int lcdparam_solve_edp_link(uint8 *data);
+
+int lcdparam_optimize_init_sequence(uint8 *data, const struct lcdparam_options *opts);
+int lcdparam_is_edid(const uint8 *buf, int len);
+int lcdparam_edid_read(FILE *fp, uint8 *data);
+
+int lcdparam_bmp_load(const char *path, struct lcdparam_image *img);
+int lcdparam_image_scale(const struct lcdparam_image *src, struct lcdparam_image *dst);
+void lcdparam_image_free(struct lcdparam_image *img);
+int lcdparam_logo_key(const char *bmp, const uint8 *data, uint32 *key);
+uint8 *lcdparam_logo_build(const char *bmp, const uint8 *data, uint32 *len);
+
+int lcdparam_catalog_open(struct lcdparam_catalog *cat, const char *path);
+void lcdparam_catalog_close(struct lcdparam_catalog *cat);
+const uint8 *lcdparam_catalog_find(const struct lcdparam_catalog *cat, const char *name);
+const uint8 *lcdparam_catalog_find_board(const struct lcdparam_catalog *cat, const char *board);
+const uint8 *lcdparam_catalog_find_serial(const struct lcdparam_catalog *cat, const char *serial);
+int lcdparam_catalog_build(const char *manifest, const char *path);
+
+#endif
@@ -0,0 +1,493 @@
+/*********************************************************************************
+* Copyright 2019 Bob Shen
+* FileName: lcdparam_catalog.c
+* Author: Bob Shen
+* Version: 1.0.0
+* Date: 2019-3-14
+* Description:
+*     Panel catalog, many compiled lcdparam profiles in one mmap-able file.
+*     A profile is found by name or board id through a hash index, or by
+*     serial number through a sorted range table, without parsing the file.
+*
+* Revision:
+*     Date:
+*     Reviser:
+*     Description:
+*********************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "lcdparam.h"
+
+#define CATALOG_MAX_PROFILES        65536
+
+struct catalog_entry {
+    char name[32];
+    char board[32];
+    char serial_first[32];
+    char serial_last[32];
+    LCDPARAM_STORGAE_T blob;
+};
+
+static uint32_t catalog_hash(const char *s)
+{
+    uint32_t hash = 2166136261u; // FNV-1a
+
+    while (*s) {
+        hash ^= (uint8)*s++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/* serials are ordered by length first, so SN9 < SN10 and SN100 > SN2 */
+static int serial_compare(const char *a, const char *b)
+{
+    size_t la = strlen(a), lb = strlen(b);
+
+    if (la != lb) {
+        return la < lb ? -1 : 1;
+    }
+
+    return strcmp(a, b);
+}
+
+static const char *catalog_string(const struct lcdparam_catalog *cat, uint32_t offset)
+{
+    /* the string block ends in '\0', checked by lcdparam_catalog_open() */
+    if (offset >= cat->header->string_size) {
+        return "";
+    }
+
+    return (const char *)cat->base + cat->header->string_offset + offset;
+}
+
+static const uint8 *catalog_blob(const struct lcdparam_catalog *cat, uint32_t profile)
+{
+    const struct lcdparam_catalog_profile *p;
+
+    if (profile >= cat->header->profile_count) {
+        return NULL;
+    }
+
+    p = (const struct lcdparam_catalog_profile *)(cat->base + cat->header->profile_offset) + profile;
+    if (cat->size < LCDPARAM_STORGAE_DATA_LEN || p->blob > cat->size - LCDPARAM_STORGAE_DATA_LEN) {
+        return NULL;
+    }
+
+    return cat->base + p->blob;
+}
+
+/**
+* @decs: 映射屏参数据库文件
+* @param: cat, path
+* @return: 0：success <0: failed
+*/
+int lcdparam_catalog_open(struct lcdparam_catalog *cat, const char *path)
+{
+    const struct lcdparam_catalog_header *header;
+    struct stat st;
+    void *base;
+    int fd;
+
+    memset(cat, 0, sizeof(*cat));
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        LCDPARAM_LOGE("%s, open %s failed", __func__, path);
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(*header)) {
+        LCDPARAM_LOGE("%s, %s is too small", __func__, path);
+        close(fd);
+        return -1;
+    }
+
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        LCDPARAM_LOGE("%s, mmap %s failed", __func__, path);
+        return -1;
+    }
+
+    header = base;
+    if (header->magic != LCDPARAM_CATALOG_MAGIC
+        || header->version != LCDPARAM_CATALOG_VERSION
+        || header->size != (uint32_t)st.st_size
+        || header->bucket_count == 0
+        || (header->bucket_count & (header->bucket_count - 1))
+        || header->profile_offset + (uint64_t)header->profile_count * sizeof(struct lcdparam_catalog_profile) > header->size
+        || header->index_offset + (uint64_t)header->bucket_count * sizeof(struct lcdparam_catalog_bucket) > header->size
+        || header->serial_offset + (uint64_t)header->serial_count * sizeof(struct lcdparam_catalog_serial) > header->size
+        || header->string_size == 0
+        || (uint64_t)header->string_offset + header->string_size > header->size
+        || ((const uint8 *)base)[header->string_offset + header->string_size - 1] != '\0') {
+        LCDPARAM_LOGE("%s, %s is not a valid catalog", __func__, path);
+        munmap(base, st.st_size);
+        return -1;
+    }
+
+    cat->base = base;
+    cat->size = st.st_size;
+    cat->header = header;
+
+    return 0;
+}
+
+void lcdparam_catalog_close(struct lcdparam_catalog *cat)
+{
+    if (cat->base) {
+        munmap((void *)cat->base, cat->size);
+    }
+    memset(cat, 0, sizeof(*cat));
+}
+
+/**
+* @decs: 按名字在哈希索引中查找屏参
+* @param: cat, name
+* @return: 屏参数据, NULL: 未找到
+*/
+const uint8 *lcdparam_catalog_find(const struct lcdparam_catalog *cat, const char *name)
+{
+    const struct lcdparam_catalog_bucket *index;
+    uint32_t mask = cat->header->bucket_count - 1;
+    uint32_t hash = catalog_hash(name);
+    uint32_t i, n;
+
+    index = (const struct lcdparam_catalog_bucket *)(cat->base + cat->header->index_offset);
+
+    for (i = hash & mask, n = 0; n <= mask; i = (i + 1) & mask, n++) {
+        if (index[i].profile == LCDPARAM_CATALOG_EMPTY) {
+            break;
+        }
+        if (index[i].hash == hash && !strcmp(catalog_string(cat, index[i].key), name)) {
+            return catalog_blob(cat, index[i].profile);
+        }
+    }
+
+    return NULL;
+}
+
+const uint8 *lcdparam_catalog_find_board(const struct lcdparam_catalog *cat, const char *board)
+{
+    char name[64];
+
+    snprintf(name, sizeof(name), "%s%s", LCDPARAM_CATALOG_BOARD_PREFIX, board);
+    return lcdparam_catalog_find(cat, name);
+}
+
+/**
+* @decs: 按序列号在有序区间表中查找屏参
+* @param: cat, serial
+* @return: 屏参数据, NULL: 未找到
+*/
+const uint8 *lcdparam_catalog_find_serial(const struct lcdparam_catalog *cat, const char *serial)
+{
+    const struct lcdparam_catalog_serial *ranges;
+    int lo = 0, hi = (int)cat->header->serial_count - 1, found = -1;
+
+    ranges = (const struct lcdparam_catalog_serial *)(cat->base + cat->header->serial_offset);
+
+    /* last range whose first serial <= serial */
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+
+        if (serial_compare(catalog_string(cat, ranges[mid].first), serial) <= 0) {
+            found = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    if (found < 0 || serial_compare(serial, catalog_string(cat, ranges[found].last)) > 0) {
+        return NULL;
+    }
+
+    return catalog_blob(cat, ranges[found].profile);
+}
+
+static int compile_profile(struct catalog_entry *entry, const char *path)
+{
+    struct lcdparam_options opts;
+    uint32 file_crc;
+    FILE *fp;
+    int ret;
+
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        LCDPARAM_LOGE("open %s failed", path);
+        return -1;
+    }
+
+    file_crc = getfile_crc(fp);
+    rewind(fp);
+    ret = lcdparam_parse(fp, path, entry->blob.data, &opts);
+    fclose(fp);
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (lcdparam_check(entry->blob.data) < 0) {
+        LCDPARAM_LOGE("profile %s (%s) rejected", entry->name, path);
+        return -1;
+    }
+
+    lcdparam_set_crc(entry->blob.data, file_crc);
+    return 0;
+}
+
+static int compare_serial(const void *a, const void *b)
+{
+    const struct catalog_entry *const *ea = a;
+    const struct catalog_entry *const *eb = b;
+
+    return serial_compare((*ea)->serial_first, (*eb)->serial_first);
+}
+
+static uint32_t add_string(char *strings, uint32_t *len, const char *s)
+{
+    uint32_t offset = *len;
+
+    strcpy(strings + offset, s);
+    *len += strlen(s) + 1;
+
+    return offset;
+}
+
+static int insert_key(struct lcdparam_catalog_bucket *index, uint32_t bucket_count,
+                      const char *strings, const char *key_str, uint32_t key_offset,
+                      uint32_t profile)
+{
+    uint32_t mask = bucket_count - 1;
+    uint32_t hash = catalog_hash(key_str);
+    uint32_t i;
+
+    for (i = hash & mask; index[i].profile != LCDPARAM_CATALOG_EMPTY; i = (i + 1) & mask) {
+        if (index[i].hash == hash && !strcmp(strings + index[i].key, key_str)) {
+            LCDPARAM_LOGE("duplicate catalog key %s", key_str);
+            return -1;
+        }
+    }
+
+    index[i].hash = hash;
+    index[i].key = key_offset;
+    index[i].profile = profile;
+
+    return 0;
+}
+
+/**
+* @decs: 根据清单文件生成屏参数据库
+*     清单每行: name path [board=ID] [serial=FIRST..LAST], path相对清单所在目录
+* @param: manifest, path
+* @return: 0：success <0: failed
+*/
+int lcdparam_catalog_build(const char *manifest, const char *path)
+{
+    struct lcdparam_catalog_header header;
+    struct lcdparam_catalog_profile *profiles = NULL;
+    struct lcdparam_catalog_bucket *index = NULL;
+    struct lcdparam_catalog_serial *serials = NULL;
+    struct catalog_entry *entries = NULL;
+    struct catalog_entry **sorted = NULL;
+    char *strings = NULL;
+    uint32_t strings_len = 0;
+    uint32_t count = 0, keys = 0, serial_count = 0, i;
+    char line[1024], dir[1024], file[2048];
+    char board_key[64];
+    FILE *fp, *out = NULL;
+    int ret = -1;
+
+    fp = fopen(manifest, "r");
+    if (fp == NULL) {
+        LCDPARAM_LOGE("open %s failed", manifest);
+        return -1;
+    }
+
+    strncpy(dir, manifest, sizeof(dir) - 1);
+    dir[sizeof(dir) - 1] = '\0';
+    strcpy(dir, dirname(dir));
+
+    while (fgets(line, sizeof(line), fp)) {
+        struct catalog_entry *entry;
+        char *p = strtrim(line);
+        char *name, *src, *opt;
+
+        if (strlen(p) == 0 || p[0] == '#') {
+            continue;
+        }
+        if (count >= CATALOG_MAX_PROFILES) {
+            LCDPARAM_LOGE("too many profiles, max %d", CATALOG_MAX_PROFILES);
+            goto out;
+        }
+        if ((count & 63) == 0) {
+            entry = realloc(entries, (count + 64) * sizeof(*entries));
+            if (!entry) {
+                LCDPARAM_LOGE("out of memory");
+                goto out;
+            }
+            entries = entry;
+        }
+        entry = &entries[count];
+        memset(entry, 0, sizeof(*entry));
+
+        name = strtok(p, " \t");
+        src = strtok(NULL, " \t");
+        if (!name || !src || strlen(name) >= sizeof(entry->name)) {
+            LCDPARAM_LOGE("bad manifest line: %s", p);
+            goto out;
+        }
+        strcpy(entry->name, name);
+
+        while ((opt = strtok(NULL, " \t")) != NULL) {
+            char *range;
+
+            if (!strncmp(opt, "board=", 6) && strlen(opt + 6) < sizeof(entry->board)) {
+                strcpy(entry->board, opt + 6);
+                keys++;
+            } else if (!strncmp(opt, "serial=", 7) && (range = strstr(opt, "..")) != NULL
+                       && range - opt - 7 < (int)sizeof(entry->serial_first)
+                       && strlen(range + 2) < sizeof(entry->serial_last)) {
+                snprintf(entry->serial_first, sizeof(entry->serial_first), "%.*s",
+                         (int)(range - opt - 7), opt + 7);
+                strcpy(entry->serial_last, range + 2);
+                serial_count++;
+            } else {
+                LCDPARAM_LOGE("bad manifest option %s for %s", opt, name);
+                goto out;
+            }
+        }
+
+        if (src[0] == '/') {
+            snprintf(file, sizeof(file), "%s", src);
+        } else {
+            snprintf(file, sizeof(file), "%s/%s", dir, src);
+        }
+        if (compile_profile(entry, file) < 0) {
+            goto out;
+        }
+        count++;
+    }
+    keys += count;
+
+    if (count == 0) {
+        LCDPARAM_LOGE("%s has no profile", manifest);
+        goto out;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic = LCDPARAM_CATALOG_MAGIC;
+    header.version = LCDPARAM_CATALOG_VERSION;
+    header.profile_count = count;
+    header.serial_count = serial_count;
+    for (header.bucket_count = 16; header.bucket_count < keys * 2; header.bucket_count <<= 1)
+        ;
+
+    profiles = calloc(count, sizeof(*profiles));
+    index = malloc(header.bucket_count * sizeof(*index));
+    serials = calloc(serial_count + 1, sizeof(*serials));
+    sorted = calloc(serial_count + 1, sizeof(*sorted));
+    strings = malloc(count * (sizeof(board_key) + 32 * 3));
+    if (!profiles || !index || !serials || !sorted || !strings) {
+        LCDPARAM_LOGE("out of memory");
+        goto out;
+    }
+    memset(index, 0xff, header.bucket_count * sizeof(*index));
+
+    header.profile_offset = sizeof(header);
+    header.index_offset = header.profile_offset + count * sizeof(*profiles);
+    header.serial_offset = header.index_offset + header.bucket_count * sizeof(*index);
+    header.string_offset = header.serial_offset + serial_count * sizeof(*serials);
+
+    for (i = 0; i < count; i++) {
+        profiles[i].name = add_string(strings, &strings_len, entries[i].name);
+        if (insert_key(index, header.bucket_count, strings, entries[i].name,
+                       profiles[i].name, i) < 0) {
+            goto out;
+        }
+
+        if (entries[i].board[0]) {
+            uint32_t offset;
+
+            snprintf(board_key, sizeof(board_key), "%s%s",
+                     LCDPARAM_CATALOG_BOARD_PREFIX, entries[i].board);
+            offset = add_string(strings, &strings_len, board_key);
+            if (insert_key(index, header.bucket_count, strings, board_key, offset, i) < 0) {
+                goto out;
+            }
+        }
+    }
+
+    for (i = 0, serial_count = 0; i < count; i++) {
+        if (entries[i].serial_first[0]) {
+            sorted[serial_count++] = &entries[i];
+        }
+    }
+    qsort(sorted, serial_count, sizeof(*sorted), compare_serial);
+    for (i = 0; i < serial_count; i++) {
+        if (serial_compare(sorted[i]->serial_first, sorted[i]->serial_last) > 0
+            || (i > 0 && serial_compare(sorted[i - 1]->serial_last, sorted[i]->serial_first) >= 0)) {
+            LCDPARAM_LOGE("serial range of %s is empty or overlaps", sorted[i]->name);
+            goto out;
+        }
+        serials[i].first = add_string(strings, &strings_len, sorted[i]->serial_first);
+        serials[i].last = add_string(strings, &strings_len, sorted[i]->serial_last);
+        serials[i].profile = sorted[i] - entries;
+    }
+
+    header.string_size = strings_len;
+
+    /* blobs are sector aligned so they can be written as they are */
+    for (i = 0; i < count; i++) {
+        profiles[i].blob = ((header.string_offset + strings_len + LCDPARAM_STORGAE_DATA_LEN - 1)
+                            / LCDPARAM_STORGAE_DATA_LEN + i) * LCDPARAM_STORGAE_DATA_LEN;
+    }
+    header.size = profiles[count - 1].blob + LCDPARAM_STORGAE_DATA_LEN;
+
+    out = fopen(path, "wb");
+    if (out == NULL) {
+        LCDPARAM_LOGE("open %s failed", path);
+        goto out;
+    }
+
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(profiles, sizeof(*profiles), count, out);
+    fwrite(index, sizeof(*index), header.bucket_count, out);
+    fwrite(serials, sizeof(*serials), serial_count, out);
+    fwrite(strings, 1, strings_len, out);
+    for (i = 0; i < count; i++) {
+        fseek(out, profiles[i].blob, SEEK_SET);
+        fwrite(entries[i].blob.data, 1, LCDPARAM_STORGAE_DATA_LEN, out);
+    }
+
+    if (ferror(out)) {
+        LCDPARAM_LOGE("write %s failed", path);
+        goto out;
+    }
+
+    LCDPARAM_LOGI("%s: %u profiles, %u buckets, %u serial ranges, %u bytes",
+                  path, count, header.bucket_count, serial_count, header.size);
+    ret = 0;
+
+out:
+    if (out) {
+        fclose(out);
+    }
+    fclose(fp);
+    free(strings);
+    free(sorted);
+    free(serials);
+    free(index);
+    free(profiles);
+    free(entries);
+    return ret;
+}
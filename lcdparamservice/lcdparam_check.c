@@ -0,0 +1,372 @@
+/*********************************************************************************
+* Copyright 2019 Bob Shen
+* FileName: lcdparam_check.c
+* Author: Bob Shen
+* Version: 1.0.0
+* Date: 2019-3-14
+* Description:
+*     Validate the panel timing and interface parameters before they are
+*     written to the lcdparam partition, so that a typo is reported at once
+*     instead of after a reboot to a black panel.
+*
+* Revision:
+*     Date:
+*     Reviser:
+*     Description:
+*********************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "lcdparam.h"
+
+/* RK3288 VOP limits */
+#define VOP_MAX_HACTIVE             4096
+#define VOP_MAX_VACTIVE             4096
+#define VOP_MAX_HTOTAL              8191
+#define VOP_MAX_VTOTAL              8191
+#define VOP_MAX_DCLK                594000000
+
+#define VREFRESH_MIN                20
+#define VREFRESH_MAX                240
+#define VREFRESH_WARN_MIN           30
+#define VREFRESH_WARN_MAX           120
+
+/* pixel clock range of one lvds channel */
+#define LVDS_CHANNEL_PCLK_MIN       20000000
+#define LVDS_CHANNEL_PCLK_MAX       100000000
+
+static int errors;
+static int warnings;
+
+#define CHECK_ERROR(fmt, ...) \
+    do { \
+        LCDPARAM_LOGE(fmt, ##__VA_ARGS__); \
+        errors++; \
+    } while (0)
+
+#define CHECK_WARN(fmt, ...) \
+    do { \
+        LCDPARAM_LOGW(fmt, ##__VA_ARGS__); \
+        warnings++; \
+    } while (0)
+
+struct key_range {
+    int index;
+    uint32 min;
+    uint32 max;
+};
+
+/* ranges a key has on its own, whatever the other keys are */
+static const struct key_range key_ranges[] = {
+    { LCDPARAM_PANEL_TYPE, PANEL_TYPE_DSI, PANEL_TYPE_LVDS },
+    { LCDPARAM_UBOOT_INIT, 0, 1 },
+    { LCDPARAM_LOGO_FORMAT, LOGO_FORMAT_AUTO, LOGO_FORMAT_RGB565 },
+    { LCDPARAM_HACTIVE, 1, VOP_MAX_HACTIVE },
+    { LCDPARAM_VACTIVE, 1, VOP_MAX_VACTIVE },
+    { LCDPARAM_CLOCK_FREQUENCY, 1000000, VOP_MAX_DCLK },
+    { LCDPARAM_HSYNC_LEN, 1, 1023 },
+    { LCDPARAM_VSYNC_LEN, 1, 1023 },
+    { LCDPARAM_HFRONT_PORCH, 0, 2047 },
+    { LCDPARAM_HBACK_PORCH, 0, 2047 },
+    { LCDPARAM_VFRONT_PORCH, 0, 1023 },
+    { LCDPARAM_VBACK_PORCH, 0, 1023 },
+    { LCDPARAM_HSYNC_ACTIVE, 0, 1 },
+    { LCDPARAM_VSYNC_ACTIVE, 0, 1 },
+    { LCDPARAM_DE_ACTIVE, 0, 1 },
+    { LCDPARAM_PIXELCLK_ACTIVE, 0, 1 },
+    { LCDPARAM_LVDS_FORMAT, 0, 3 },
+    { LCDPARAM_LVDS_MODE, 0, 1 },
+    { LCDPARAM_LVDS_CHANNEL, 0, 1 },
+};
+
+static void check_range(const uint8 *data, int index)
+{
+    uint32 value = lcdparam_get(data, index);
+    int i;
+
+    for (i = 0; i < (int)(sizeof(key_ranges) / sizeof(key_ranges[0])); i++) {
+        if (key_ranges[i].index != index) {
+            continue;
+        }
+        if (value < key_ranges[i].min || value > key_ranges[i].max) {
+            CHECK_ERROR("%s = %lu, must be %lu..%lu", key[index], value,
+                        key_ranges[i].min, key_ranges[i].max);
+        }
+        return;
+    }
+}
+
+/**
+* @decs: 按drm_mode_vrefresh()的算法计算htotal/vtotal和刷新率
+* @param: data, timing
+* @return: 0：success <0: failed
+*/
+int lcdparam_get_timing(const uint8 *data, struct lcdparam_timing *timing)
+{
+    unsigned int clock, calc_val;
+
+    timing->clock = lcdparam_get(data, LCDPARAM_CLOCK_FREQUENCY);
+    timing->htotal = lcdparam_get(data, LCDPARAM_HACTIVE)
+                     + lcdparam_get(data, LCDPARAM_HFRONT_PORCH)
+                     + lcdparam_get(data, LCDPARAM_HSYNC_LEN)
+                     + lcdparam_get(data, LCDPARAM_HBACK_PORCH);
+    timing->vtotal = lcdparam_get(data, LCDPARAM_VACTIVE)
+                     + lcdparam_get(data, LCDPARAM_VFRONT_PORCH)
+                     + lcdparam_get(data, LCDPARAM_VSYNC_LEN)
+                     + lcdparam_get(data, LCDPARAM_VBACK_PORCH);
+    timing->vrefresh = 0;
+
+    if (timing->htotal <= 0 || timing->vtotal <= 0) {
+        return -1;
+    }
+
+    /* same as drm_mode_vrefresh(), mode->clock is in kHz */
+    clock = timing->clock / 1000;
+    calc_val = clock * 1000;
+    calc_val /= timing->htotal;
+    timing->vrefresh = (calc_val + timing->vtotal / 2) / timing->vtotal;
+
+    return 0;
+}
+
+static void check_timing(const uint8 *data, struct lcdparam_timing *timing)
+{
+    int hactive = lcdparam_get(data, LCDPARAM_HACTIVE);
+    int vactive = lcdparam_get(data, LCDPARAM_VACTIVE);
+    int i;
+
+    check_range(data, LCDPARAM_HACTIVE);
+    check_range(data, LCDPARAM_VACTIVE);
+    check_range(data, LCDPARAM_CLOCK_FREQUENCY);
+    check_range(data, LCDPARAM_HSYNC_LEN);
+    check_range(data, LCDPARAM_VSYNC_LEN);
+    check_range(data, LCDPARAM_HFRONT_PORCH);
+    check_range(data, LCDPARAM_HBACK_PORCH);
+    check_range(data, LCDPARAM_VFRONT_PORCH);
+    check_range(data, LCDPARAM_VBACK_PORCH);
+
+    for (i = LCDPARAM_HSYNC_ACTIVE; i <= LCDPARAM_PIXELCLK_ACTIVE; i++) {
+        check_range(data, i);
+    }
+
+    if (lcdparam_get(data, LCDPARAM_HFRONT_PORCH) == 0) {
+        CHECK_WARN("hfront-porch = 0, most panels need at least 1");
+    }
+    if (lcdparam_get(data, LCDPARAM_VFRONT_PORCH) == 0) {
+        CHECK_WARN("vfront-porch = 0, most panels need at least 1");
+    }
+
+    if (lcdparam_get_timing(data, timing) < 0) {
+        CHECK_ERROR("htotal/vtotal is 0");
+        return;
+    }
+
+    if (timing->htotal > VOP_MAX_HTOTAL) {
+        CHECK_ERROR("htotal = %d, must be <= %d", timing->htotal, VOP_MAX_HTOTAL);
+    }
+    if (timing->vtotal > VOP_MAX_VTOTAL) {
+        CHECK_ERROR("vtotal = %d, must be <= %d", timing->vtotal, VOP_MAX_VTOTAL);
+    }
+    if (hactive > 0 && timing->htotal > hactive * 2) {
+        CHECK_WARN("horizontal blanking %d is larger than hactive %d",
+                   timing->htotal - hactive, hactive);
+    }
+    if (vactive > 0 && timing->vtotal > vactive * 2) {
+        CHECK_WARN("vertical blanking %d is larger than vactive %d",
+                   timing->vtotal - vactive, vactive);
+    }
+
+    if (timing->vrefresh < VREFRESH_MIN || timing->vrefresh > VREFRESH_MAX) {
+        CHECK_ERROR("refresh rate %d Hz (clock-frequency %lu / htotal %d / vtotal %d), must be %d..%d Hz",
+                    timing->vrefresh, timing->clock, timing->htotal, timing->vtotal,
+                    VREFRESH_MIN, VREFRESH_MAX);
+    } else if (timing->vrefresh < VREFRESH_WARN_MIN || timing->vrefresh > VREFRESH_WARN_MAX) {
+        CHECK_WARN("refresh rate %d Hz is unusual, check clock-frequency and porches",
+                   timing->vrefresh);
+    }
+}
+
+static void check_lvds(const uint8 *data, const struct lcdparam_timing *timing)
+{
+    uint32 format = lcdparam_get(data, LCDPARAM_LVDS_FORMAT);
+    uint32 width = lcdparam_get(data, LCDPARAM_LVDS_WIDTH);
+    uint32 channel = lcdparam_get(data, LCDPARAM_LVDS_CHANNEL);
+    uint32 channels = channel ? 2 : 1;
+    uint32 pclk_min = LVDS_CHANNEL_PCLK_MIN * channels;
+    uint32 pclk_max = LVDS_CHANNEL_PCLK_MAX * channels;
+    int i;
+
+    check_range(data, LCDPARAM_LVDS_FORMAT);
+    check_range(data, LCDPARAM_LVDS_MODE);
+    check_range(data, LCDPARAM_LVDS_CHANNEL);
+
+    if (width != 18 && width != 24) {
+        CHECK_ERROR("lvds,width = %lu, must be 18 or 24", width);
+    } else if (width == 18 && format >= 2) {
+        CHECK_WARN("lvds,width = 18 with a 24bit lvds,format, colors will be truncated");
+    } else if (width == 24 && format == 1) {
+        CHECK_WARN("lvds,width = 24 with lvds,format RGB666");
+    }
+
+    if (timing->clock < pclk_min || timing->clock > pclk_max) {
+        CHECK_ERROR("clock-frequency %lu out of %s lvds range %lu..%lu",
+                    timing->clock, channel ? "dual" : "single", pclk_min, pclk_max);
+    }
+
+    if (channel) {
+        for (i = LCDPARAM_HACTIVE; i <= LCDPARAM_HBACK_PORCH; i++) {
+            if (lcdparam_get(data, i) & 1) {
+                CHECK_ERROR("%s = %lu, must be even for dual lvds",
+                            key[i], lcdparam_get(data, i));
+            }
+        }
+    }
+}
+
+static void check_dsi(const uint8 *data)
+{
+    uint32 lanes = lcdparam_get(data, LCDPARAM_DSI_LANES);
+    uint32 format = lcdparam_get(data, LCDPARAM_DSI_FORMAT);
+    uint32 flags = lcdparam_get(data, LCDPARAM_DSI_FLAGS);
+    uint32 lane_rate = lcdparam_get(data, LCDPARAM_DSI_LANE_RATE);
+    uint32 bpp, required;
+
+    if (lanes < 1 || lanes > 4) {
+        CHECK_ERROR("dsi,lanes = %lu, must be 1..4", lanes);
+        return;
+    }
+    if (lcdparam_dsi_bpp(format) < 0) {
+        CHECK_ERROR("dsi,format = %lu, must be 0..3", format);
+        return;
+    }
+
+    bpp = lcdparam_dsi_bpp(format);
+    required = (uint32)((lcdparam_dsi_bandwidth(data) + 999999) / 1000000);
+
+    if (required > DSI_LANE_RATE_MAX) {
+        CHECK_ERROR("mode needs %lu Mbps per lane on %lu lanes, max is %d Mbps",
+                    required, lanes, DSI_LANE_RATE_MAX);
+        return;
+    }
+
+    if (lane_rate == 0) {
+        CHECK_WARN("dsi,lane-rate is not set, the DT default is kept (mode needs %lu Mbps)",
+                   required);
+        return;
+    }
+    if (lane_rate < DSI_LANE_RATE_MIN || lane_rate > DSI_LANE_RATE_MAX) {
+        CHECK_WARN("dsi,lane-rate = %lu is ignored by u-boot, must be %d..%d",
+                   lane_rate, DSI_LANE_RATE_MIN, DSI_LANE_RATE_MAX);
+        return;
+    }
+    if (lane_rate < required) {
+        CHECK_ERROR("dsi,lane-rate = %lu Mbps, mode needs %lu Mbps per lane (%lu bpp, %lu lanes)",
+                    lane_rate, required, bpp, lanes);
+    } else if (!(flags & MIPI_DSI_MODE_VIDEO_BURST) && lane_rate < required * 11 / 10) {
+        CHECK_WARN("dsi,lane-rate = %lu Mbps leaves less than 10%% headroom for non-burst mode",
+                   lane_rate);
+    }
+}
+
+static void check_edp(const uint8 *data)
+{
+    uint32 link_rate = lcdparam_get(data, LCDPARAM_EDP_LINK_RATE);
+    uint32 lanes = lcdparam_get(data, LCDPARAM_EDP_LANES);
+    uint32 bpc = lcdparam_get(data, LCDPARAM_EDP_BPC);
+
+    if (bpc != 0 && bpc != 6 && bpc != 8 && bpc != 10) {
+        CHECK_ERROR("edp,bpc = %lu, must be 6 | 8 | 10", bpc);
+        return;
+    }
+    if (link_rate == 0 || lanes == 0) {
+        CHECK_WARN("edp link is not set, the link training default is kept (mode needs %llu kbps)",
+                   lcdparam_edp_required(data));
+        return;
+    }
+    if (link_rate != EDP_LINK_RATE_RBR && link_rate != EDP_LINK_RATE_HBR) {
+        CHECK_ERROR("edp,link-rate = %lu, must be %d | %d", link_rate,
+                    EDP_LINK_RATE_RBR, EDP_LINK_RATE_HBR);
+        return;
+    }
+    if (lanes != 1 && lanes != 2 && lanes != 4) {
+        CHECK_ERROR("edp,lanes = %lu, must be 1 | 2 | 4", lanes);
+        return;
+    }
+    if (lcdparam_edp_link_ok(data) < 0) {
+        CHECK_ERROR("edp link %lu Mbps x %lu lanes is too slow, mode needs %llu kbps",
+                    link_rate, lanes, lcdparam_edp_required(data));
+    }
+}
+
+static void check_general(const uint8 *data)
+{
+    uint32 orientation = lcdparam_get(data, LCDPARAM_ORIENTATION);
+    uint32 density = lcdparam_get(data, LCDPARAM_DENSITY);
+
+    check_range(data, LCDPARAM_PANEL_TYPE);
+    check_range(data, LCDPARAM_UBOOT_INIT);
+    check_range(data, LCDPARAM_LOGO_FORMAT);
+
+    if (orientation != 0 && orientation != 90 && orientation != 180 && orientation != 270) {
+        CHECK_WARN("orientation = %lu is ignored, must be 0 | 90 | 180 | 270", orientation);
+    }
+    if (density != 0 && density != 120 && density != 160 && density != 240 && density != 320) {
+        CHECK_WARN("density = %lu is ignored, must be 120 | 160 | 240 | 320", density);
+    }
+}
+
+/**
+* @decs: 写入lcdparam分区前检查参数
+* @param: data
+* @return: 0：success <0: 参数错误
+*/
+int lcdparam_check(const uint8 *data)
+{
+    struct lcdparam_timing timing;
+
+    errors = 0;
+    warnings = 0;
+
+    check_general(data);
+    check_timing(data, &timing);
+
+    switch (lcdparam_get(data, LCDPARAM_PANEL_TYPE)) {
+        case PANEL_TYPE_LVDS:
+            check_lvds(data, &timing);
+            break;
+        case PANEL_TYPE_DSI:
+            check_dsi(data);
+            break;
+        case PANEL_TYPE_EDP:
+            check_edp(data);
+            break;
+        default:
+            break;
+    }
+
+    LCDPARAM_LOGI("%dx%d htotal %d vtotal %d clock %lu Hz refresh %d Hz: %d error(s), %d warning(s)",
+                  (int)lcdparam_get(data, LCDPARAM_HACTIVE), (int)lcdparam_get(data, LCDPARAM_VACTIVE),
+                  timing.htotal, timing.vtotal, timing.clock, timing.vrefresh, errors, warnings);
+
+    return errors ? -1 : 0;
+}
+
+/**
+* @decs: -w修改一个值后的检查, 分区已有参数(crc非0)时检查全部参数,
+*        空白或未写完的分区只检查这个值的范围
+* @param: data, index
+* @return: 0：success <0: 参数错误
+*/
+int lcdparam_check_edit(const uint8 *data, int index)
+{
+    if (lcdparam_get_crc(data) != 0) {
+        return lcdparam_check(data);
+    }
+
+    errors = 0;
+    warnings = 0;
+    check_range(data, index);
+
+    return errors ? -1 : 0;
+}
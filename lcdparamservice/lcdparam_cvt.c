@@ -0,0 +1,155 @@
+/*********************************************************************************
+* Copyright 2019 Bob Shen
+* FileName: lcdparam_cvt.c
+* Author: Bob Shen
+* Version: 1.0.0
+* Date: 2019-3-14
+* Description:
+*     Synthesize a full panel timing from resolution and refresh rate with
+*     the VESA CVT and CVT reduced blanking formulas, same as drm_cvt_mode()
+*     in the kernel.
+*
+* Revision:
+*     Date:
+*     Reviser:
+*     Description:
+*********************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "lcdparam.h"
+
+#define HV_FACTOR                   1000
+#define CVT_H_GRANULARITY           8
+#define CVT_MIN_V_PORCH             3
+#define CVT_MIN_V_BPORCH            6
+#define CVT_CLOCK_STEP              250 // kHz
+
+/* CVT */
+#define CVT_MIN_VSYNC_BP            550
+#define CVT_HSYNC_PERCENTAGE        8
+#define CVT_M_FACTOR                600
+#define CVT_C_FACTOR                40
+#define CVT_K_FACTOR                128
+#define CVT_J_FACTOR                20
+#define CVT_M_PRIME                 (CVT_M_FACTOR * CVT_K_FACTOR / 256)
+#define CVT_C_PRIME                 ((CVT_C_FACTOR - CVT_J_FACTOR) * CVT_K_FACTOR / 256 + CVT_J_FACTOR)
+
+/* CVT reduced blanking */
+#define CVT_RB_MIN_VBLANK           460
+#define CVT_RB_H_SYNC               32
+#define CVT_RB_H_BLANK              160
+#define CVT_RB_VFPORCH              3
+
+static int cvt_vsync_len(int hactive, int vactive)
+{
+    if (!(vactive % 3) && (vactive * 4 / 3) == hactive) {
+        return 4;
+    } else if (!(vactive % 9) && (vactive * 16 / 9) == hactive) {
+        return 5;
+    } else if (!(vactive % 10) && (vactive * 16 / 10) == hactive) {
+        return 6;
+    } else if (!(vactive % 4) && (vactive * 5 / 4) == hactive) {
+        return 7;
+    } else if (!(vactive % 9) && (vactive * 15 / 9) == hactive) {
+        return 7;
+    }
+
+    return 10;
+}
+
+/**
+* @decs: 按CVT/CVT-RB公式生成时序并写入屏参
+* @param: data, hactive, vactive, vrefresh, reduced
+* @return: 0：success <0: failed
+*/
+int lcdparam_cvt(uint8 *data, int hactive, int vactive, int vrefresh, int reduced)
+{
+    int hdisplay_rnd = hactive - hactive % CVT_H_GRANULARITY;
+    int vsync = cvt_vsync_len(hactive, vactive);
+    int htotal, hsync_start, hsync_end;
+    int vtotal, vsync_start, vsync_end;
+    long long tmp1, tmp2, hperiod, clock;
+
+    if (hactive <= 0 || vactive <= 0 || vrefresh <= 0) {
+        LCDPARAM_LOGE("invalid mode %dx%d@%d", hactive, vactive, vrefresh);
+        return -1;
+    }
+
+    if (!reduced) {
+        int vsync_bp, hblank, hblank_percentage;
+
+        tmp1 = (long long)HV_FACTOR * 1000000 - (long long)CVT_MIN_VSYNC_BP * HV_FACTOR * vrefresh;
+        tmp2 = (vactive + CVT_MIN_V_PORCH) * 2;
+        hperiod = tmp1 * 2 / (tmp2 * vrefresh);
+
+        vsync_bp = CVT_MIN_VSYNC_BP * HV_FACTOR / hperiod + 1;
+        if (vsync_bp < vsync + CVT_MIN_V_PORCH) {
+            vsync_bp = vsync + CVT_MIN_V_PORCH;
+        }
+        vtotal = vactive + vsync_bp + CVT_MIN_V_PORCH;
+
+        hblank_percentage = CVT_C_PRIME * HV_FACTOR - CVT_M_PRIME * hperiod / 1000;
+        if (hblank_percentage < 20 * HV_FACTOR) {
+            hblank_percentage = 20 * HV_FACTOR;
+        }
+        hblank = hdisplay_rnd * hblank_percentage / (100 * HV_FACTOR - hblank_percentage);
+        hblank -= hblank % (2 * CVT_H_GRANULARITY);
+
+        htotal = hdisplay_rnd + hblank;
+        hsync_end = hdisplay_rnd + hblank / 2;
+        hsync_start = hsync_end - htotal * CVT_HSYNC_PERCENTAGE / 100;
+        hsync_start += CVT_H_GRANULARITY - hsync_start % CVT_H_GRANULARITY;
+        vsync_start = vactive + CVT_MIN_V_PORCH;
+        vsync_end = vsync_start + vsync;
+    } else {
+        int vbilines;
+
+        tmp1 = (long long)HV_FACTOR * 1000000 - (long long)CVT_RB_MIN_VBLANK * HV_FACTOR * vrefresh;
+        tmp2 = vactive;
+        hperiod = tmp1 / (tmp2 * vrefresh);
+
+        vbilines = CVT_RB_MIN_VBLANK * HV_FACTOR / hperiod + 1;
+        if (vbilines < CVT_RB_VFPORCH + vsync + CVT_MIN_V_BPORCH) {
+            vbilines = CVT_RB_VFPORCH + vsync + CVT_MIN_V_BPORCH;
+        }
+        vtotal = vactive + vbilines;
+
+        htotal = hdisplay_rnd + CVT_RB_H_BLANK;
+        hsync_end = hdisplay_rnd + CVT_RB_H_BLANK / 2;
+        hsync_start = hsync_end - CVT_RB_H_SYNC;
+        vsync_start = vactive + CVT_RB_VFPORCH;
+        vsync_end = vsync_start + vsync;
+    }
+
+    /* pixel clock in kHz, rounded down to the CVT clock step */
+    clock = (long long)htotal * HV_FACTOR * 1000 / hperiod;
+    clock -= clock % CVT_CLOCK_STEP;
+
+    /* keep the active area the panel asked for, the blanking follows it */
+    htotal += hactive - hdisplay_rnd;
+    hsync_start += hactive - hdisplay_rnd;
+    hsync_end += hactive - hdisplay_rnd;
+
+    lcdparam_set(data, LCDPARAM_CLOCK_FREQUENCY, clock * 1000);
+    lcdparam_set(data, LCDPARAM_HACTIVE, hactive);
+    lcdparam_set(data, LCDPARAM_HFRONT_PORCH, hsync_start - hactive);
+    lcdparam_set(data, LCDPARAM_HSYNC_LEN, hsync_end - hsync_start);
+    lcdparam_set(data, LCDPARAM_HBACK_PORCH, htotal - hsync_end);
+    lcdparam_set(data, LCDPARAM_VACTIVE, vactive);
+    lcdparam_set(data, LCDPARAM_VFRONT_PORCH, vsync_start - vactive);
+    lcdparam_set(data, LCDPARAM_VSYNC_LEN, vsync_end - vsync_start);
+    lcdparam_set(data, LCDPARAM_VBACK_PORCH, vtotal - vsync_end);
+
+    /* CVT uses -hsync +vsync, reduced blanking uses +hsync -vsync */
+    lcdparam_set(data, LCDPARAM_HSYNC_ACTIVE, reduced ? 1 : 0);
+    lcdparam_set(data, LCDPARAM_VSYNC_ACTIVE, reduced ? 0 : 1);
+
+    LCDPARAM_LOGI("mode %dx%d@%d %s: clock %lld kHz, H %d %d %d %d, V %d %d %d %d",
+                  hactive, vactive, vrefresh, reduced ? "cvt-rb" : "cvt", clock,
+                  hactive, hsync_start, hsync_end, htotal,
+                  vactive, vsync_start, vsync_end, vtotal);
+
+    return 0;
+}
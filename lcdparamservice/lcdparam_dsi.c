@@ -0,0 +1,131 @@
+/*********************************************************************************
+* Copyright 2019 Bob Shen
+* FileName: lcdparam_dsi.c
+* Author: Bob Shen
+* Version: 1.0.0
+* Date: 2019-3-14
+* Description:
+*     Compute the mipi dsi lane rate from the pixel clock, the pixel format,
+*     the lane count and the video mode when dsi,lane-rate is not set.
+*
+* Revision:
+*     Date:
+*     Reviser:
+*     Description:
+*********************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "lcdparam.h"
+
+#define DSI_LANE_RATE_STEP          10 // Mbps
+
+/*
+ * Packet bytes per line besides the pixels: non-burst sends hss, hse, the
+ * pixel packet and the hbp/hfp blanking packets, burst only hss and the
+ * pixel packet before the lanes drop to lp.
+ */
+#define DSI_NON_BURST_LINE_OVERHEAD 26
+#define DSI_BURST_LINE_OVERHEAD     10
+
+static const int dsi_format_bpp[] = {
+    24, // MIPI_DSI_FMT_RGB888
+    18, // MIPI_DSI_FMT_RGB666
+    18, // MIPI_DSI_FMT_RGB666_PACKED
+    16, // MIPI_DSI_FMT_RGB565
+};
+
+int lcdparam_dsi_bpp(uint32 format)
+{
+    if (format >= sizeof(dsi_format_bpp) / sizeof(dsi_format_bpp[0])) {
+        return -1;
+    }
+
+    return dsi_format_bpp[format];
+}
+
+static unsigned long long dsi_bandwidth(const uint8 *data, int burst)
+{
+    struct lcdparam_timing timing;
+    uint32 lanes = lcdparam_get(data, LCDPARAM_DSI_LANES);
+    int bpp = lcdparam_dsi_bpp(lcdparam_get(data, LCDPARAM_DSI_FORMAT));
+    int hactive = lcdparam_get(data, LCDPARAM_HACTIVE);
+    unsigned long long bytes;
+
+    if (lcdparam_get_timing(data, &timing) < 0 || timing.clock == 0 || timing.htotal <= 0
+        || lanes < 1 || lanes > 4 || bpp < 0) {
+        return 0;
+    }
+
+    if (burst) {
+        bytes = ((unsigned long long)hactive * bpp + 7) / 8 + DSI_BURST_LINE_OVERHEAD;
+    } else {
+        bytes = ((unsigned long long)timing.htotal * bpp + 7) / 8 + DSI_NON_BURST_LINE_OVERHEAD;
+    }
+
+    return (unsigned long long)timing.clock * bytes * 8 / timing.htotal / lanes;
+}
+
+/**
+* @decs: 每lane所需的bps, non-burst以像素时钟发送整行含消隐, burst只发送有效像素
+* @param: data
+* @return: bps, 0: 参数无效
+*/
+unsigned long long lcdparam_dsi_bandwidth(const uint8 *data)
+{
+    return dsi_bandwidth(data, lcdparam_get(data, LCDPARAM_DSI_FLAGS) & MIPI_DSI_MODE_VIDEO_BURST);
+}
+
+/**
+* @decs: dsi,lane-rate未设置或为auto时, 计算所需的lane rate并写入屏参
+* @param: data, opts
+* @return: 0：success <0: 通道数无法承载该模式
+*/
+int lcdparam_solve_lane_rate(uint8 *data, const struct lcdparam_options *opts)
+{
+    uint32 lanes = lcdparam_get(data, LCDPARAM_DSI_LANES);
+    uint32 flags = lcdparam_get(data, LCDPARAM_DSI_FLAGS);
+    int bpp = lcdparam_dsi_bpp(lcdparam_get(data, LCDPARAM_DSI_FORMAT));
+    int headroom = opts->lane_rate_headroom ? opts->lane_rate_headroom : DSI_LANE_RATE_HEADROOM;
+    int burst = (flags & MIPI_DSI_MODE_VIDEO_BURST) != 0;
+    unsigned long long bandwidth;
+    uint32 required, other, lane_rate;
+
+    if (lcdparam_get(data, LCDPARAM_PANEL_TYPE) != PANEL_TYPE_DSI
+        || lcdparam_get(data, LCDPARAM_DSI_LANE_RATE) != 0) {
+        return 0;
+    }
+
+    bandwidth = dsi_bandwidth(data, burst);
+    if (bandwidth == 0) {
+        /* left to lcdparam_check() to report */
+        return 0;
+    }
+
+    /* Mbps per lane of the pixels and packets, before the headroom */
+    required = (bandwidth + 999999) / 1000000;
+    other = (dsi_bandwidth(data, !burst) + 999999) / 1000000;
+    if (required > DSI_LANE_RATE_MAX) {
+        LCDPARAM_LOGE("dsi,lane-rate = auto: mode needs %lu Mbps per lane on %lu lanes, max is %d Mbps, use more lanes",
+                      required, lanes, DSI_LANE_RATE_MAX);
+        return -1;
+    }
+
+    lane_rate = (bandwidth * (100 + headroom) / 100 + 999999) / 1000000;
+    lane_rate = (lane_rate + DSI_LANE_RATE_STEP - 1) / DSI_LANE_RATE_STEP * DSI_LANE_RATE_STEP;
+    if (lane_rate > DSI_LANE_RATE_MAX) {
+        LCDPARAM_LOGW("dsi,lane-rate = auto: %lu Mbps with %d%% headroom clamped to %d Mbps",
+                      lane_rate, headroom, DSI_LANE_RATE_MAX);
+        lane_rate = DSI_LANE_RATE_MAX;
+    } else if (lane_rate < DSI_LANE_RATE_MIN) {
+        lane_rate = DSI_LANE_RATE_MIN;
+    }
+
+    lcdparam_set(data, LCDPARAM_DSI_LANE_RATE, lane_rate);
+    LCDPARAM_LOGI("dsi,lane-rate = auto: %lu Mbps (%lu Mbps for %d bpp on %lu lanes in %s mode, %s needs %lu, %d%% headroom)",
+                  lane_rate, required, bpp, lanes, burst ? "burst" : "non-burst",
+                  burst ? "non-burst" : "burst", other, headroom);
+
+    return 0;
+}
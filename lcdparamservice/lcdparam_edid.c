@@ -0,0 +1,261 @@
+/*********************************************************************************
+* Copyright 2019 Bob Shen
+* FileName: lcdparam_edid.c
+* Author: Bob Shen
+* Version: 1.0.0
+* Date: 2019-3-14
+* Description:
+*     Fill the panel timing, sync polarity and physical size from the
+*     preferred detailed timing descriptor of a vendor EDID dump.
+*
+* Revision:
+*     Date:
+*     Reviser:
+*     Description:
+*********************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "lcdparam.h"
+
+#define EDID_BLOCK_LEN              128
+#define EDID_MAX_BLOCKS             8
+#define EDID_DTD_LEN                18
+#define EDID_DTD_START              54
+#define EDID_DTD_COUNT              4
+#define EDID_CEA_TAG                0x02
+
+/* base block */
+#define EDID_VERSION                18
+#define EDID_REVISION               19
+#define EDID_INPUT                  20
+#define EDID_WIDTH_CM               21
+#define EDID_HEIGHT_CM              22
+#define EDID_FEATURES               24
+#define EDID_EXTENSIONS             126
+
+#define EDID_INPUT_DIGITAL          (1 << 7)
+#define EDID_FEATURE_PREFERRED      (1 << 1)
+
+/* detailed timing flags */
+#define DTD_INTERLACED              (1 << 7)
+#define DTD_SYNC_DIGITAL_SEPARATE   (3 << 3)
+#define DTD_VSYNC_POSITIVE          (1 << 2)
+#define DTD_HSYNC_POSITIVE          (1 << 1)
+
+static const uint8 edid_header[8] = { 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00 };
+
+struct edid_dtd {
+    uint32 clock;               // Hz
+    int hactive, hfront_porch, hsync_len, hback_porch;
+    int vactive, vfront_porch, vsync_len, vback_porch;
+    int hsync_positive, vsync_positive;
+    int interlaced;
+    int width_mm, height_mm;
+};
+
+int lcdparam_is_edid(const uint8 *buf, int len)
+{
+    return len >= (int)sizeof(edid_header) && !memcmp(buf, edid_header, sizeof(edid_header));
+}
+
+static int edid_block_valid(const uint8 *block)
+{
+    uint8 sum = 0;
+    int i;
+
+    for (i = 0; i < EDID_BLOCK_LEN; i++) {
+        sum += block[i];
+    }
+
+    return sum == 0;
+}
+
+static int edid_parse_dtd(const uint8 *d, struct edid_dtd *dtd)
+{
+    int hblank, vblank;
+
+    /* a zero pixel clock marks a display descriptor, not a timing */
+    if (d[0] == 0 && d[1] == 0) {
+        return -1;
+    }
+
+    dtd->clock = (uint32)(d[0] | d[1] << 8) * 10000;
+    dtd->hactive = d[2] | (d[4] & 0xf0) << 4;
+    hblank = d[3] | (d[4] & 0x0f) << 8;
+    dtd->vactive = d[5] | (d[7] & 0xf0) << 4;
+    vblank = d[6] | (d[7] & 0x0f) << 8;
+    dtd->hfront_porch = d[8] | (d[11] & 0xc0) << 2;
+    dtd->hsync_len = d[9] | (d[11] & 0x30) << 4;
+    dtd->vfront_porch = (d[10] >> 4) | (d[11] & 0x0c) << 2;
+    dtd->vsync_len = (d[10] & 0x0f) | (d[11] & 0x03) << 4;
+    dtd->hback_porch = hblank - dtd->hfront_porch - dtd->hsync_len;
+    dtd->vback_porch = vblank - dtd->vfront_porch - dtd->vsync_len;
+    dtd->width_mm = d[12] | (d[14] & 0xf0) << 4;
+    dtd->height_mm = d[13] | (d[14] & 0x0f) << 8;
+    dtd->interlaced = !!(d[17] & DTD_INTERLACED);
+
+    /* analog and composite sync carry no per line polarity, use negative */
+    if ((d[17] & DTD_SYNC_DIGITAL_SEPARATE) == DTD_SYNC_DIGITAL_SEPARATE) {
+        dtd->hsync_positive = !!(d[17] & DTD_HSYNC_POSITIVE);
+        dtd->vsync_positive = !!(d[17] & DTD_VSYNC_POSITIVE);
+    } else {
+        dtd->hsync_positive = 0;
+        dtd->vsync_positive = 0;
+    }
+
+    if (dtd->hactive == 0 || dtd->vactive == 0 || dtd->hback_porch < 0 || dtd->vback_porch < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int dtd_refresh(const struct edid_dtd *dtd)
+{
+    unsigned long long total = (unsigned long long)(dtd->hactive + dtd->hfront_porch + dtd->hsync_len
+                               + dtd->hback_porch) * (dtd->vactive + dtd->vfront_porch
+                               + dtd->vsync_len + dtd->vback_porch);
+
+    return (int)((dtd->clock + total / 2) / total);
+}
+
+/* collect the descriptors of the base block first, then of the cea blocks */
+static int edid_collect(const uint8 *edid, int blocks, struct edid_dtd *dtds, int max)
+{
+    int count = 0;
+    int b, offset, i;
+
+    for (i = 0; i < EDID_DTD_COUNT && count < max; i++) {
+        if (!edid_parse_dtd(edid + EDID_DTD_START + i * EDID_DTD_LEN, &dtds[count])) {
+            count++;
+        }
+    }
+
+    for (b = 1; b < blocks; b++) {
+        const uint8 *ext = edid + b * EDID_BLOCK_LEN;
+
+        if (ext[0] != EDID_CEA_TAG) {
+            continue;
+        }
+        offset = ext[2];
+        if (offset < 4) {
+            continue;
+        }
+        for (; offset + EDID_DTD_LEN <= EDID_BLOCK_LEN - 1 && count < max; offset += EDID_DTD_LEN) {
+            if (!edid_parse_dtd(ext + offset, &dtds[count])) {
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+/**
+* @decs: 读取EDID, 用首选的详细时序填充时序, 同步极性和屏幕尺寸
+* @param: fp, data
+* @return: 0：success <0: failed
+*/
+int lcdparam_edid_read(FILE *fp, uint8 *data)
+{
+    uint8 edid[EDID_BLOCK_LEN * EDID_MAX_BLOCKS];
+    struct edid_dtd dtds[EDID_DTD_COUNT * EDID_MAX_BLOCKS];
+    const struct edid_dtd *dtd;
+    int len, blocks, count, bpc, i;
+
+    len = fread(edid, 1, sizeof(edid), fp);
+    if (len < EDID_BLOCK_LEN || !lcdparam_is_edid(edid, len)) {
+        LCDPARAM_LOGE("edid: no edid header");
+        return -1;
+    }
+    if (!edid_block_valid(edid)) {
+        LCDPARAM_LOGE("edid: base block checksum error");
+        return -1;
+    }
+
+    blocks = 1 + edid[EDID_EXTENSIONS];
+    if (blocks > len / EDID_BLOCK_LEN) {
+        LCDPARAM_LOGW("edid: %d extension block(s) announced, %d present",
+                      blocks - 1, len / EDID_BLOCK_LEN - 1);
+        blocks = len / EDID_BLOCK_LEN;
+    }
+    for (i = 1; i < blocks; i++) {
+        if (!edid_block_valid(edid + i * EDID_BLOCK_LEN)) {
+            LCDPARAM_LOGW("edid: extension block %d checksum error, ignored", i);
+            blocks = i;
+            break;
+        }
+    }
+
+    count = edid_collect(edid, blocks, dtds, sizeof(dtds) / sizeof(dtds[0]));
+    if (count == 0) {
+        LCDPARAM_LOGE("edid: no detailed timing descriptor");
+        return -1;
+    }
+
+    /* the first descriptor is the preferred mode, from edid 1.3 on always */
+    dtd = &dtds[0];
+    for (i = 0; i < count; i++) {
+        if (!dtds[i].interlaced) {
+            dtd = &dtds[i];
+            break;
+        }
+    }
+    if (dtd->interlaced) {
+        LCDPARAM_LOGE("edid: only interlaced timings, not supported");
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        LCDPARAM_LOGI("edid: %c %dx%d@%d%s clock %lu Hz", &dtds[i] == dtd ? '*' : ' ',
+                      dtds[i].hactive, dtds[i].vactive, dtd_refresh(&dtds[i]),
+                      dtds[i].interlaced ? "i" : "", dtds[i].clock);
+    }
+    if (dtd != &dtds[0]) {
+        LCDPARAM_LOGW("edid: preferred timing is interlaced, using the first progressive one");
+    } else if (edid[EDID_VERSION] == 1 && edid[EDID_REVISION] < 3
+               && !(edid[EDID_FEATURES] & EDID_FEATURE_PREFERRED)) {
+        LCDPARAM_LOGW("edid %d.%d has no preferred timing, using the first one",
+                      edid[EDID_VERSION], edid[EDID_REVISION]);
+    }
+
+    lcdparam_set(data, LCDPARAM_CLOCK_FREQUENCY, dtd->clock);
+    lcdparam_set(data, LCDPARAM_HACTIVE, dtd->hactive);
+    lcdparam_set(data, LCDPARAM_HFRONT_PORCH, dtd->hfront_porch);
+    lcdparam_set(data, LCDPARAM_HSYNC_LEN, dtd->hsync_len);
+    lcdparam_set(data, LCDPARAM_HBACK_PORCH, dtd->hback_porch);
+    lcdparam_set(data, LCDPARAM_VACTIVE, dtd->vactive);
+    lcdparam_set(data, LCDPARAM_VFRONT_PORCH, dtd->vfront_porch);
+    lcdparam_set(data, LCDPARAM_VSYNC_LEN, dtd->vsync_len);
+    lcdparam_set(data, LCDPARAM_VBACK_PORCH, dtd->vback_porch);
+    lcdparam_set(data, LCDPARAM_HSYNC_ACTIVE, dtd->hsync_positive);
+    lcdparam_set(data, LCDPARAM_VSYNC_ACTIVE, dtd->vsync_positive);
+
+    /* the descriptor size is in mm, the base block one only in cm */
+    if (dtd->width_mm && dtd->height_mm) {
+        lcdparam_set(data, LCDPARAM_WIDTH_MM, dtd->width_mm);
+        lcdparam_set(data, LCDPARAM_HEIGHT_MM, dtd->height_mm);
+    } else if (edid[EDID_WIDTH_CM] && edid[EDID_HEIGHT_CM]) {
+        lcdparam_set(data, LCDPARAM_WIDTH_MM, edid[EDID_WIDTH_CM] * 10);
+        lcdparam_set(data, LCDPARAM_HEIGHT_MM, edid[EDID_HEIGHT_CM] * 10);
+    }
+
+    /* edid 1.4 digital input carries the bit depth, 6, 8 or 10 bits per color */
+    bpc = (edid[EDID_INPUT] >> 4) & 0x7;
+    if (edid[EDID_VERSION] == 1 && edid[EDID_REVISION] >= 4 && (edid[EDID_INPUT] & EDID_INPUT_DIGITAL)
+        && bpc >= 1 && bpc <= 3 && lcdparam_get(data, LCDPARAM_EDP_BPC) == 0) {
+        lcdparam_set(data, LCDPARAM_EDP_BPC, 4 + bpc * 2);
+    }
+
+    LCDPARAM_LOGI("edid %d.%d: %dx%d@%d, H %d %d %d V %d %d %d, %s/%s sync, %lux%lu mm",
+                  edid[EDID_VERSION], edid[EDID_REVISION],
+                  dtd->hactive, dtd->vactive, dtd_refresh(dtd),
+                  dtd->hfront_porch, dtd->hsync_len, dtd->hback_porch,
+                  dtd->vfront_porch, dtd->vsync_len, dtd->vback_porch,
+                  dtd->hsync_positive ? "+h" : "-h", dtd->vsync_positive ? "+v" : "-v",
+                  lcdparam_get(data, LCDPARAM_WIDTH_MM), lcdparam_get(data, LCDPARAM_HEIGHT_MM));
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+/*********************************************************************************
+* Copyright 2019 Bob Shen
+* FileName: lcdparam_edp.c
+* Author: Bob Shen
+* Version: 1.0.0
+* Date: 2019-3-14
+* Description:
+*     Pick the smallest edp main link, link rate times lane count, which can
+*     carry the pixel stream of the mode when edp,link-rate or edp,lanes is
+*     auto.
+*
+* Revision:
+*     Date:
+*     Reviser:
+*     Description:
+*********************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "lcdparam.h"
+
+static const int edp_link_rates[] = { EDP_LINK_RATE_RBR, EDP_LINK_RATE_HBR };
+static const int edp_lane_counts[] = { 1, 2, 4 };
+
+#define ARRAY_SIZE(x)               (int)(sizeof(x) / sizeof((x)[0]))
+
+/* payload kbps of a link, 8b/10b leaves 8 data bits of every 10 */
+static unsigned long long edp_capacity(int link_rate, int lanes)
+{
+    return (unsigned long long)link_rate * 1000 * lanes * 8 / 10;
+}
+
+static int edp_valid_rate(uint32 link_rate)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(edp_link_rates); i++) {
+        if (link_rate == (uint32)edp_link_rates[i]) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+* @decs: 计算edp传输模式所需的带宽
+* @param: data
+* @return: kbps, 0: 参数错误
+*/
+unsigned long long lcdparam_edp_required(const uint8 *data)
+{
+    uint32 clock = lcdparam_get(data, LCDPARAM_CLOCK_FREQUENCY);
+    uint32 bpc = lcdparam_get(data, LCDPARAM_EDP_BPC);
+
+    if (bpc == 0) {
+        bpc = EDP_BPC_DEFAULT;
+    }
+    if (bpc != 6 && bpc != 8 && bpc != 10) {
+        return 0;
+    }
+
+    return ((unsigned long long)clock * bpc * 3 + 999) / 1000;
+}
+
+/**
+* @decs: 检查edp链路是否能承载该模式
+* @param: data
+* @return: 0：success <0: 链路带宽不足或参数错误
+*/
+int lcdparam_edp_link_ok(const uint8 *data)
+{
+    uint32 link_rate = lcdparam_get(data, LCDPARAM_EDP_LINK_RATE);
+    uint32 lanes = lcdparam_get(data, LCDPARAM_EDP_LANES);
+    unsigned long long required = lcdparam_edp_required(data);
+
+    if (!edp_valid_rate(link_rate) || (lanes != 1 && lanes != 2 && lanes != 4) || !required) {
+        return -1;
+    }
+
+    return edp_capacity(link_rate, lanes) >= required ? 0 : -1;
+}
+
+/**
+* @decs: edp,link-rate或edp,lanes为auto时, 选择能承载该模式的最小链路
+* @param: data
+* @return: 0：success <0: 链路无法承载该模式
+*/
+int lcdparam_solve_edp_link(uint8 *data)
+{
+    uint32 link_rate = lcdparam_get(data, LCDPARAM_EDP_LINK_RATE);
+    uint32 lanes = lcdparam_get(data, LCDPARAM_EDP_LANES);
+    unsigned long long required, capacity, best = 0;
+    int best_rate = 0, best_lanes = 0;
+    int i, j;
+
+    if (lcdparam_get(data, LCDPARAM_PANEL_TYPE) != PANEL_TYPE_EDP
+        || (link_rate != 0 && lanes != 0)) {
+        return 0;
+    }
+
+    required = lcdparam_edp_required(data);
+    if (!required) {
+        /* left to lcdparam_check() to report */
+        return 0;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(edp_lane_counts); i++) {
+        if (lanes != 0 && lanes != (uint32)edp_lane_counts[i]) {
+            continue;
+        }
+        for (j = 0; j < ARRAY_SIZE(edp_link_rates); j++) {
+            if (link_rate != 0 && link_rate != (uint32)edp_link_rates[j]) {
+                continue;
+            }
+
+            capacity = edp_capacity(edp_link_rates[j], edp_lane_counts[i]);
+            if (capacity >= required && (!best || capacity < best)) {
+                best = capacity;
+                best_rate = edp_link_rates[j];
+                best_lanes = edp_lane_counts[i];
+            }
+        }
+    }
+
+    if (!best) {
+        LCDPARAM_LOGE("edp: no link%s%s carries %llu kbps, max is %d Mbps x 4 lanes",
+                      link_rate ? " at the given edp,link-rate" : "",
+                      lanes ? " with the given edp,lanes" : "",
+                      required, EDP_LINK_RATE_HBR);
+        return -1;
+    }
+
+    lcdparam_set(data, LCDPARAM_EDP_LINK_RATE, best_rate);
+    lcdparam_set(data, LCDPARAM_EDP_LANES, best_lanes);
+    LCDPARAM_LOGI("edp link = auto: %d Mbps x %d lanes, %llu of %llu kbps used",
+                  best_rate, best_lanes, required, best);
+
+    return 0;
+}
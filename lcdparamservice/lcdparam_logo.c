@@ -0,0 +1,700 @@
+/*********************************************************************************
+* Copyright 2019 Bob Shen
+* FileName: lcdparam_logo.c
+* Author: Bob Shen
+* Version: 1.0.0
+* Date: 2019-3-14
+* Description:
+*     Resample logo.bmp to the panel resolution and store it in the logo slot
+*     of the lcdparam partition in a format the vop scans out directly, so
+*     that u-boot neither decodes nor scales the boot logo.
+*
+* Revision:
+*     Date:
+*     Reviser:
+*     Description:
+*********************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <math.h>
+
+#include "lcdparam.h"
+
+#define BMP_FILE_HEADER_LEN         14
+#define BMP_BI_RGB                  0
+#define BMP_BI_BITFIELDS            3
+
+/* filter coefficients are Q14 fixed point */
+#define SCALE_PRECISION             14
+#define SCALE_ROUND                 (1 << (SCALE_PRECISION - 1))
+#define SCALE_SUPPORT               2.0 // catmull-rom
+
+/* 32x32 pixels of 3 bytes, one tile of source and destination stay in L1 */
+#define ROTATE_TILE                 32
+
+static uint32 get_le16(const uint8 *p)
+{
+    return p[0] | p[1] << 8;
+}
+
+static uint32 get_le32(const uint8 *p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32)p[3] << 24;
+}
+
+void lcdparam_image_free(struct lcdparam_image *img)
+{
+    free(img->pixels);
+    img->pixels = NULL;
+}
+
+static uint8 *read_file(const char *path, long *len)
+{
+    uint8 *buf;
+    FILE *fp;
+
+    fp = fopen(path, "rb");
+    if (fp == NULL) {
+        LCDPARAM_LOGE("open %s failed", path);
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    *len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    buf = malloc(*len > 0 ? *len : 1);
+    if (buf == NULL || fread(buf, 1, *len, fp) != (size_t)*len) {
+        LCDPARAM_LOGE("read %s failed", path);
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+
+    return buf;
+}
+
+/**
+* @decs: 解码8/24/32位未压缩bmp
+* @param: path, img
+* @return: 0：success <0: failed
+*/
+int lcdparam_bmp_load(const char *path, struct lcdparam_image *img)
+{
+    const uint8 *palette, *row;
+    uint8 *buf, *dst;
+    long len;
+    uint32 offset, dib_len, bpp, compression, colors, stride;
+    int width, height, top_down, x, y;
+
+    buf = read_file(path, &len);
+    if (buf == NULL) {
+        return -1;
+    }
+
+    if (len < BMP_FILE_HEADER_LEN + 40 || buf[0] != 'B' || buf[1] != 'M') {
+        LCDPARAM_LOGE("%s is not a bmp", path);
+        goto err;
+    }
+
+    offset = get_le32(buf + 10);
+    dib_len = get_le32(buf + 14);
+    width = (int)get_le32(buf + 18);
+    height = (int)get_le32(buf + 22);
+    bpp = get_le16(buf + 28);
+    compression = get_le32(buf + 30);
+    colors = get_le32(buf + 46);
+
+    top_down = height < 0;
+    if (top_down) {
+        height = -height;
+    }
+    if (width <= 0 || height <= 0 || width > 8192 || height > 8192) {
+        LCDPARAM_LOGE("%s: invalid size %dx%d", path, width, height);
+        goto err;
+    }
+    if (!(bpp == 8 && compression == BMP_BI_RGB) && !(bpp == 24 && compression == BMP_BI_RGB)
+        && !(bpp == 32 && (compression == BMP_BI_RGB || compression == BMP_BI_BITFIELDS))) {
+        LCDPARAM_LOGE("%s: %lu bpp, compression %lu not supported, use 8/24/32 bpp uncompressed",
+                      path, bpp, compression);
+        goto err;
+    }
+
+    stride = ((uint32)width * bpp + 31) / 32 * 4;
+    if (colors == 0) {
+        colors = 256;
+    }
+    /* bounded before any pointer is formed, uint32 is 32 bit on the device */
+    if (dib_len > (uint32)len - BMP_FILE_HEADER_LEN || (bpp == 8 && colors > (1u << bpp))) {
+        LCDPARAM_LOGE("%s: invalid header, dib size %lu, %lu colors", path, dib_len, colors);
+        goto err;
+    }
+    if (offset > (uint32)len || (unsigned long long)stride * height > (uint32)len - offset
+        || (bpp == 8 && colors * 4 > (uint32)len - BMP_FILE_HEADER_LEN - dib_len)) {
+        LCDPARAM_LOGE("%s is truncated", path);
+        goto err;
+    }
+    palette = buf + BMP_FILE_HEADER_LEN + dib_len;
+
+    img->width = width;
+    img->height = height;
+    img->pixels = malloc((size_t)width * height * 3);
+    if (img->pixels == NULL) {
+        goto err;
+    }
+
+    for (y = 0; y < height; y++) {
+        row = buf + offset + (size_t)stride * (top_down ? y : height - 1 - y);
+        dst = img->pixels + (size_t)y * width * 3;
+
+        switch (bpp) {
+            case 8:
+                for (x = 0; x < width; x++) {
+                    const uint8 *c = palette + (row[x] < colors ? row[x] : 0) * 4;
+
+                    dst[x * 3] = c[0];
+                    dst[x * 3 + 1] = c[1];
+                    dst[x * 3 + 2] = c[2];
+                }
+                break;
+            case 24:
+                memcpy(dst, row, (size_t)width * 3);
+                break;
+            case 32:
+                for (x = 0; x < width; x++) {
+                    dst[x * 3] = row[x * 4];
+                    dst[x * 3 + 1] = row[x * 4 + 1];
+                    dst[x * 3 + 2] = row[x * 4 + 2];
+                }
+                break;
+        }
+    }
+
+    free(buf);
+    return 0;
+
+err:
+    free(buf);
+    return -1;
+}
+
+static double cubic(double x)
+{
+    /* catmull-rom, a = -0.5 */
+    const double a = -0.5;
+
+    if (x < 0.0) {
+        x = -x;
+    }
+    if (x < 1.0) {
+        return ((a + 2.0) * x - (a + 3.0)) * x * x + 1;
+    }
+    if (x < 2.0) {
+        return (((x - 5) * x + 8) * x - 4) * a;
+    }
+
+    return 0.0;
+}
+
+struct scale_coeffs {
+    int taps;
+    int *first;                     // first input index of every output
+    int *coeffs;                    // taps per output, Q14
+};
+
+/*
+ * Downscaling widens the filter to the scale factor, so every input pixel
+ * contributes, upscaling interpolates with the plain kernel.
+ */
+static int scale_coeffs_init(struct scale_coeffs *c, int in, int out)
+{
+    double scale = (double)in / out;
+    double fscale = scale > 1.0 ? scale : 1.0;
+    double support = SCALE_SUPPORT * fscale;
+    double w[64];
+    int i, k;
+
+    c->taps = (int)ceil(support) * 2 + 1;
+    if (c->taps > (int)(sizeof(w) / sizeof(w[0]))) {
+        LCDPARAM_LOGE("logo downscale %d -> %d too large", in, out);
+        return -1;
+    }
+    c->first = malloc(out * sizeof(int));
+    c->coeffs = calloc((size_t)out * c->taps, sizeof(int));
+    if (c->first == NULL || c->coeffs == NULL) {
+        free(c->first);
+        free(c->coeffs);
+        return -1;
+    }
+
+    for (i = 0; i < out; i++) {
+        double center = (i + 0.5) * scale;
+        double sum = 0.0;
+        int xmin = (int)floor(center - support + 0.5);
+        int xmax = (int)floor(center + support + 0.5);
+        int *coeff = c->coeffs + (size_t)i * c->taps;
+
+        if (xmin < 0) {
+            xmin = 0;
+        }
+        if (xmax > in) {
+            xmax = in;
+        }
+        if (xmax - xmin > c->taps) {
+            xmax = xmin + c->taps;
+        }
+
+        for (k = 0; k < xmax - xmin; k++) {
+            w[k] = cubic((k + xmin - center + 0.5) / fscale);
+            sum += w[k];
+        }
+        for (k = 0; k < xmax - xmin; k++) {
+            coeff[k] = (int)lround(w[k] / sum * (1 << SCALE_PRECISION));
+        }
+
+        /* keep the input window inside the image for the fixed tap count */
+        if (xmin + c->taps > in) {
+            int shift = xmin + c->taps - in;
+
+            if (shift > xmin) {
+                shift = xmin;
+            }
+            memmove(coeff + shift, coeff, (c->taps - shift) * sizeof(int));
+            memset(coeff, 0, shift * sizeof(int));
+            xmin -= shift;
+        }
+        c->first[i] = xmin;
+    }
+
+    return 0;
+}
+
+static void scale_coeffs_free(struct scale_coeffs *c)
+{
+    free(c->first);
+    free(c->coeffs);
+}
+
+static uint8 clamp8(int v)
+{
+    v = (v + SCALE_ROUND) >> SCALE_PRECISION;
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+/**
+* @decs: 可分离的catmull-rom滤波缩放, dst的宽高由调用者设置
+*        内层循环按连续字节累加, 便于编译器向量化为neon
+* @param: src, dst
+* @return: 0：success <0: failed
+*/
+int lcdparam_image_scale(const struct lcdparam_image *src, struct lcdparam_image *dst)
+{
+    struct scale_coeffs hc, vc;
+    uint8 *tmp;
+    int *acc;
+    int x, y, k, c, taps;
+    size_t tmp_stride = (size_t)dst->width * 3;
+
+    if (scale_coeffs_init(&hc, src->width, dst->width) < 0) {
+        return -1;
+    }
+    if (scale_coeffs_init(&vc, src->height, dst->height) < 0) {
+        scale_coeffs_free(&hc);
+        return -1;
+    }
+
+    tmp = malloc(tmp_stride * src->height);
+    acc = malloc(tmp_stride * sizeof(int));
+    dst->pixels = malloc(tmp_stride * dst->height);
+    if (tmp == NULL || acc == NULL || dst->pixels == NULL) {
+        free(tmp);
+        free(acc);
+        lcdparam_image_free(dst);
+        scale_coeffs_free(&hc);
+        scale_coeffs_free(&vc);
+        return -1;
+    }
+
+    /* horizontal pass, src->height lines of dst->width */
+    taps = hc.taps < src->width ? hc.taps : src->width;
+    for (y = 0; y < src->height; y++) {
+        const uint8 *in = src->pixels + (size_t)y * src->width * 3;
+        uint8 *out = tmp + (size_t)y * tmp_stride;
+
+        for (x = 0; x < dst->width; x++) {
+            const int *coeff = hc.coeffs + (size_t)x * hc.taps;
+            const uint8 *p = in + hc.first[x] * 3;
+            int b = 0, g = 0, r = 0;
+
+            for (k = 0; k < taps; k++) {
+                b += p[k * 3] * coeff[k];
+                g += p[k * 3 + 1] * coeff[k];
+                r += p[k * 3 + 2] * coeff[k];
+            }
+            out[x * 3] = clamp8(b);
+            out[x * 3 + 1] = clamp8(g);
+            out[x * 3 + 2] = clamp8(r);
+        }
+    }
+
+    /* vertical pass, whole lines at a time */
+    taps = vc.taps < src->height ? vc.taps : src->height;
+    for (y = 0; y < dst->height; y++) {
+        const int *coeff = vc.coeffs + (size_t)y * vc.taps;
+        uint8 *out = dst->pixels + (size_t)y * tmp_stride;
+
+        memset(acc, 0, tmp_stride * sizeof(int));
+        for (k = 0; k < taps; k++) {
+            const uint8 *in = tmp + (size_t)(vc.first[y] + k) * tmp_stride;
+            int w = coeff[k];
+
+            if (w == 0) {
+                continue;
+            }
+            for (c = 0; c < (int)tmp_stride; c++) {
+                acc[c] += in[c] * w;
+            }
+        }
+        for (c = 0; c < (int)tmp_stride; c++) {
+            out[c] = clamp8(acc[c]);
+        }
+    }
+
+    free(tmp);
+    free(acc);
+    scale_coeffs_free(&hc);
+    scale_coeffs_free(&vc);
+
+    return 0;
+}
+
+static void encode_rgb888(const struct lcdparam_image *canvas, struct lcdparam_logo_header *header,
+                          uint8 *pixels)
+{
+    int y;
+
+    for (y = 0; y < canvas->height; y++) {
+        memcpy(pixels + (size_t)y * header->stride,
+               canvas->pixels + (size_t)y * canvas->width * 3, (size_t)canvas->width * 3);
+    }
+}
+
+static int clamp_error(int v)
+{
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+/*
+ * Floyd-Steinberg error diffusion to rgb565, little endian with red in the
+ * top bits like the 16 bpp bmp logos. The error of every channel is carried
+ * to the right and to the next line.
+ */
+static void encode_rgb565(const struct lcdparam_image *canvas, struct lcdparam_logo_header *header,
+                          uint8 *pixels)
+{
+    static const int bits[3] = { 5, 6, 5 };    // b, g, r
+    int width = canvas->width;
+    int *err, *cur, *next;
+    int x, y, c;
+
+    err = calloc((size_t)(width + 2) * 3 * 2, sizeof(int));
+    if (err == NULL) {
+        /* plain truncation rather than no logo at all */
+        for (y = 0; y < canvas->height; y++) {
+            const uint8 *in = canvas->pixels + (size_t)y * width * 3;
+            uint8 *out = pixels + (size_t)y * header->stride;
+
+            for (x = 0; x < width; x++) {
+                uint32 v = (in[x * 3 + 2] >> 3) << 11 | (in[x * 3 + 1] >> 2) << 5 | in[x * 3] >> 3;
+
+                out[x * 2] = v & 0xff;
+                out[x * 2 + 1] = v >> 8;
+            }
+        }
+        return;
+    }
+
+    for (y = 0; y < canvas->height; y++) {
+        const uint8 *in = canvas->pixels + (size_t)y * width * 3;
+        uint8 *out = pixels + (size_t)y * header->stride;
+
+        /* one pixel of margin on both sides of the line */
+        cur = err + ((y & 1) ? (width + 2) * 3 : 0);
+        next = err + ((y & 1) ? 0 : (width + 2) * 3);
+        memset(next, 0, (size_t)(width + 2) * 3 * sizeof(int));
+
+        for (x = 0; x < width; x++) {
+            int q[3];
+
+            for (c = 0; c < 3; c++) {
+                int i = (x + 1) * 3 + c;
+                int v = clamp_error(in[x * 3 + c] + (cur[i] >> 4));
+                int level = v >> (8 - bits[c]);
+                int back = (level << (8 - bits[c])) | (level >> (2 * bits[c] - 8));
+                int e = v - back;
+
+                q[c] = level;
+                cur[i + 3] += e * 7;
+                next[i - 3] += e * 3;
+                next[i] += e * 5;
+                next[i + 3] += e;
+            }
+
+            out[x * 2] = (q[1] << 5 | q[0]) & 0xff;
+            out[x * 2 + 1] = (q[2] << 11 | q[1] << 5) >> 8;
+        }
+    }
+
+    free(err);
+}
+
+/* rgb565 gives nothing away on a bus of 6 bits per color or less */
+static int panel_narrow_bus(const uint8 *data)
+{
+    uint32 format;
+
+    switch (lcdparam_get(data, LCDPARAM_PANEL_TYPE)) {
+        case PANEL_TYPE_LVDS:
+            format = lcdparam_get(data, LCDPARAM_LVDS_FORMAT);
+            return lcdparam_get(data, LCDPARAM_LVDS_WIDTH) == 18 || format <= 1;
+        case PANEL_TYPE_DSI:
+            return lcdparam_dsi_bpp(lcdparam_get(data, LCDPARAM_DSI_FORMAT)) <= 18;
+        case PANEL_TYPE_EDP:
+            return lcdparam_get(data, LCDPARAM_EDP_BPC) == 6;
+        default:
+            return 0;
+    }
+}
+
+/**
+* @decs: 顺时针旋转90/180/270度, 按块转置, 避免逐列访问源图时的cache miss
+* @param: src, dst(宽高和像素由本函数设置), rotation
+* @return: 0：success <0: failed
+*/
+static int image_rotate(const struct lcdparam_image *src, struct lcdparam_image *dst, int rotation)
+{
+    int sw = src->width, sh = src->height;
+    int tx, ty, x, y;
+
+    dst->width = rotation == 180 ? sw : sh;
+    dst->height = rotation == 180 ? sh : sw;
+    dst->pixels = malloc((size_t)sw * sh * 3);
+    if (dst->pixels == NULL) {
+        return -1;
+    }
+
+    for (ty = 0; ty < dst->height; ty += ROTATE_TILE) {
+        int th = dst->height - ty < ROTATE_TILE ? dst->height - ty : ROTATE_TILE;
+
+        for (tx = 0; tx < dst->width; tx += ROTATE_TILE) {
+            int tw = dst->width - tx < ROTATE_TILE ? dst->width - tx : ROTATE_TILE;
+
+            for (y = ty; y < ty + th; y++) {
+                uint8 *out = dst->pixels + ((size_t)y * dst->width + tx) * 3;
+                const uint8 *in;
+                ptrdiff_t step;
+
+                /* source pixel of (tx, y) and the distance to the next one */
+                if (rotation == 90) {
+                    in = src->pixels + ((size_t)(sh - 1 - tx) * sw + y) * 3;
+                    step = -(ptrdiff_t)sw * 3;
+                } else if (rotation == 270) {
+                    in = src->pixels + ((size_t)tx * sw + (sw - 1 - y)) * 3;
+                    step = (ptrdiff_t)sw * 3;
+                } else {
+                    in = src->pixels + ((size_t)(sh - 1 - y) * sw + (sw - 1 - tx)) * 3;
+                    step = -3;
+                }
+
+                for (x = 0; x < tw; x++, out += 3, in += step) {
+                    out[0] = in[0];
+                    out[1] = in[1];
+                    out[2] = in[2];
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int logo_rotation(const uint8 *data)
+{
+    int rotation = lcdparam_get(data, LCDPARAM_ORIENTATION);
+
+    return (rotation == 90 || rotation == 180 || rotation == 270) ? rotation : 0;
+}
+
+/* logo,format resolved to the LCDPARAM_LOGO_FMT_* stored in the slot */
+static uint32 logo_format(const uint8 *data)
+{
+    uint32 format = lcdparam_get(data, LCDPARAM_LOGO_FORMAT);
+
+    if (format == LOGO_FORMAT_AUTO && panel_narrow_bus(data)) {
+        format = LOGO_FORMAT_RGB565;
+    }
+
+    switch (format) {
+        case LOGO_FORMAT_RGB565:
+            return LCDPARAM_LOGO_FMT_RGB565;
+        default:
+            return LCDPARAM_LOGO_FMT_RGB888;
+    }
+}
+
+/**
+* @decs: logo槽的key: bmp文件crc, 屏分辨率, 格式和旋转, 不用转换bmp即可比较
+* @param: bmp, data(屏参), key
+* @return: 0：success <0: failed
+*/
+int lcdparam_logo_key(const char *bmp, const uint8 *data, uint32 *key)
+{
+    uint32_t key_data[4];
+    FILE *fp;
+
+    fp = fopen(bmp, "rb");
+    if (fp == NULL) {
+        LCDPARAM_LOGE("open %s failed", bmp);
+        return -1;
+    }
+    *key = getfile_crc(fp);
+    fclose(fp);
+
+    key_data[0] = lcdparam_get(data, LCDPARAM_HACTIVE);
+    key_data[1] = lcdparam_get(data, LCDPARAM_VACTIVE);
+    key_data[2] = logo_format(data);
+    key_data[3] = logo_rotation(data);
+    *key = get_crc32(*key, (uint8 *)key_data, sizeof(key_data));
+
+    return 0;
+}
+
+/**
+* @decs: 生成logo槽数据: 保持宽高比缩放到屏分辨率, 居中, 四周补黑
+*        按orientation预先旋转, 再按logo,format编码为vop可直接显示的格式
+* @param: bmp, data(屏参), len(返回槽数据长度)
+* @return: 槽数据(头 + 像素), 由调用者free, NULL: failed
+*/
+uint8 *lcdparam_logo_build(const char *bmp, const uint8 *data, uint32 *len)
+{
+    struct lcdparam_image src, scaled, canvas, rotated;
+    struct lcdparam_logo_header *header;
+    uint8 *slot;
+    int width = lcdparam_get(data, LCDPARAM_HACTIVE);
+    int height = lcdparam_get(data, LCDPARAM_VACTIVE);
+    int rotation = logo_rotation(data);
+    uint32 format = logo_format(data);
+    int view_width, view_height;
+    uint32 stride, size, key;
+    int x0, y0, y;
+
+    if (width <= 0 || height <= 0) {
+        LCDPARAM_LOGE("logo: no panel resolution");
+        return NULL;
+    }
+
+    /* the logo is laid out as the user sees the mounted panel */
+    view_width = (rotation == 90 || rotation == 270) ? height : width;
+    view_height = (rotation == 90 || rotation == 270) ? width : height;
+
+    switch (format) {
+        case LCDPARAM_LOGO_FMT_RGB565:
+            stride = ((uint32)width * 2 + 3) & ~3;
+            size = stride * height;
+            break;
+        default:
+            stride = ((uint32)width * 3 + 3) & ~3;
+            size = stride * height;
+            break;
+    }
+
+    if (lcdparam_logo_key(bmp, data, &key) < 0) {
+        return NULL;
+    }
+
+    if (lcdparam_bmp_load(bmp, &src) < 0) {
+        return NULL;
+    }
+
+    /* fit inside the panel and keep the aspect ratio */
+    if ((long long)src.width * view_height > (long long)src.height * view_width) {
+        scaled.width = view_width;
+        scaled.height = (int)(((long long)src.height * view_width + src.width / 2) / src.width);
+    } else {
+        scaled.height = view_height;
+        scaled.width = (int)(((long long)src.width * view_height + src.height / 2) / src.height);
+    }
+    if (scaled.width < 1) {
+        scaled.width = 1;
+    }
+    if (scaled.height < 1) {
+        scaled.height = 1;
+    }
+
+    if (scaled.width == src.width && scaled.height == src.height) {
+        scaled.pixels = src.pixels;
+        src.pixels = NULL;
+    } else if (lcdparam_image_scale(&src, &scaled) < 0) {
+        lcdparam_image_free(&src);
+        return NULL;
+    }
+    lcdparam_image_free(&src);
+
+    canvas.width = view_width;
+    canvas.height = view_height;
+    canvas.pixels = calloc((size_t)width * height, 3);
+    *len = LCDPARAM_LOGO_DATA_OFFSET + size;
+    slot = calloc(1, *len);
+    if (canvas.pixels == NULL || slot == NULL) {
+        lcdparam_image_free(&canvas);
+        lcdparam_image_free(&scaled);
+        free(slot);
+        return NULL;
+    }
+
+    x0 = (view_width - scaled.width) / 2;
+    y0 = (view_height - scaled.height) / 2;
+    for (y = 0; y < scaled.height; y++) {
+        memcpy(canvas.pixels + ((size_t)(y0 + y) * view_width + x0) * 3,
+               scaled.pixels + (size_t)y * scaled.width * 3, (size_t)scaled.width * 3);
+    }
+    lcdparam_image_free(&scaled);
+
+    if (rotation) {
+        if (image_rotate(&canvas, &rotated, rotation) < 0) {
+            lcdparam_image_free(&canvas);
+            free(slot);
+            return NULL;
+        }
+        lcdparam_image_free(&canvas);
+        canvas = rotated;
+    }
+
+    header = (struct lcdparam_logo_header *)slot;
+    header->magic = LCDPARAM_LOGO_MAGIC;
+    header->version = LCDPARAM_LOGO_VERSION;
+    header->format = format;
+    header->width = width;
+    header->height = height;
+    header->stride = stride;
+    header->size = size;
+    header->data_offset = LCDPARAM_LOGO_DATA_OFFSET;
+    header->rotation = rotation;
+
+    if (format == LCDPARAM_LOGO_FMT_RGB565) {
+        encode_rgb565(&canvas, header, slot + LCDPARAM_LOGO_DATA_OFFSET);
+    } else {
+        encode_rgb888(&canvas, header, slot + LCDPARAM_LOGO_DATA_OFFSET);
+    }
+    lcdparam_image_free(&canvas);
+
+    header->key = key;
+
+    LCDPARAM_LOGI("logo: %s %dx%d -> %dx%d at %d,%d of %dx%d, rotated %d, %s, %lu bytes",
+                  bmp, src.width, src.height, scaled.width, scaled.height, x0, y0,
+                  view_width, view_height, rotation,
+                  format == LCDPARAM_LOGO_FMT_RGB565 ? "rgb565 dithered" : "rgb888", *len);
+
+    return slot;
+}
@@ -0,0 +1,271 @@
+/*********************************************************************************
+* Copyright 2019 Bob Shen
+* FileName: lcdparam_pll.c
+* Author: Bob Shen
+* Version: 1.0.0
+* Date: 2019-3-14
+* Description:
+*     Pick the VOP dclk the RK3288 clock tree can really generate and adjust
+*     the blanking so that the refresh rate stays within a tolerance, instead
+*     of letting it drift from the value drm_mode_vrefresh() reports.
+*
+* Revision:
+*     Date:
+*     Reviser:
+*     Description:
+*********************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "lcdparam.h"
+
+/*
+ * dclk_vop = parent / div, div is 1..256.
+ * NPLL: Fout = 24MHz * NF / (NR * NO), NR 1..64, NF 1..4096, NO 1..16,
+ *       Fref = 24MHz / NR >= 269kHz, VCO = Fout * NO is 440..2200MHz.
+ * GPLL and CPLL run at fixed rates shared with other devices.
+ */
+#define PLL_FIN                     24000000ULL
+#define PLL_NR_MAX                  64
+#define PLL_NF_MAX                  4096
+#define PLL_NO_MAX                  16
+#define PLL_FREF_MIN                269000ULL
+#define PLL_VCO_MIN                 440000000ULL
+#define PLL_VCO_MAX                 2200000000ULL
+#define GPLL_RATE                   594000000ULL
+#define CPLL_RATE                   400000000ULL
+#define DCLK_DIV_MAX                256
+
+#define REFRESH_TOLERANCE_PPM       500
+
+struct dclk_config {
+    unsigned long long rate;
+    int nr;
+    int nf;
+    int no;
+    int div;
+};
+
+static unsigned long long diff_ull(unsigned long long a, unsigned long long b)
+{
+    return a > b ? a - b : b - a;
+}
+
+/* NO and the dclk divider are both post dividers, search their product */
+static void npll_nearest(unsigned long long target, struct dclk_config *best)
+{
+    unsigned long long vco, rate;
+    int p, nr, nf, no;
+
+    best->rate = 0;
+
+    for (p = 1; p <= PLL_NO_MAX * DCLK_DIV_MAX; p++) {
+        vco = target * p;
+        if (vco < PLL_VCO_MIN) {
+            continue;
+        }
+        if (vco > PLL_VCO_MAX) {
+            break;
+        }
+
+        for (no = 1; no <= PLL_NO_MAX; no++) {
+            if (p % no || p / no > DCLK_DIV_MAX || (no > 1 && (no & 1))) {
+                continue;
+            }
+            break;
+        }
+        if (no > PLL_NO_MAX) {
+            continue;
+        }
+
+        for (nr = 1; nr <= PLL_NR_MAX && PLL_FIN / nr >= PLL_FREF_MIN; nr++) {
+            nf = (vco * nr + PLL_FIN / 2) / PLL_FIN;
+            if (nf < 1 || nf > PLL_NF_MAX) {
+                continue;
+            }
+            if (PLL_FIN * nf / nr < PLL_VCO_MIN || PLL_FIN * nf / nr > PLL_VCO_MAX) {
+                continue;
+            }
+
+            rate = PLL_FIN * nf / ((unsigned long long)nr * p);
+            if (!best->rate || diff_ull(rate, target) < diff_ull(best->rate, target)) {
+                best->rate = rate;
+                best->nr = nr;
+                best->nf = nf;
+                best->no = no;
+                best->div = p / no;
+            }
+        }
+    }
+}
+
+static void fixed_nearest(unsigned long long parent, unsigned long long target,
+                          struct dclk_config *best)
+{
+    int div = (parent + target / 2) / target;
+
+    if (div < 1) {
+        div = 1;
+    } else if (div > DCLK_DIV_MAX) {
+        div = DCLK_DIV_MAX;
+    }
+
+    memset(best, 0, sizeof(*best));
+    best->rate = parent / div;
+    best->div = div;
+}
+
+static void dclk_nearest(int pll, unsigned long long target, struct dclk_config *best)
+{
+    switch (pll) {
+        case LCDPARAM_DCLK_GPLL:
+            fixed_nearest(GPLL_RATE, target, best);
+            break;
+        case LCDPARAM_DCLK_CPLL:
+            fixed_nearest(CPLL_RATE, target, best);
+            break;
+        default:
+            npll_nearest(target, best);
+            break;
+    }
+}
+
+static long long refresh_mhz(unsigned long long rate, int htotal, int vtotal)
+{
+    unsigned long long pixels = (unsigned long long)htotal * vtotal;
+
+    return (rate * 1000 + pixels / 2) / pixels;
+}
+
+static long long error_ppm(long long achieved, long long target)
+{
+    return llabs(achieved - target) * 1000000 / target;
+}
+
+/**
+* @decs: 选择可实现的dclk, 必要时调整消隐使刷新率在容差内
+* @param: data, opts
+* @return: 0：success <0: failed
+*/
+int lcdparam_solve_dclk(uint8 *data, const struct lcdparam_options *opts)
+{
+    struct lcdparam_timing timing;
+    struct dclk_config cfg, best_cfg;
+    int hfp = lcdparam_get(data, LCDPARAM_HFRONT_PORCH);
+    int vfp = lcdparam_get(data, LCDPARAM_VFRONT_PORCH);
+    int hactive = lcdparam_get(data, LCDPARAM_HACTIVE);
+    int vactive = lcdparam_get(data, LCDPARAM_VACTIVE);
+    int tolerance = opts->refresh_tolerance_ppm ? opts->refresh_tolerance_ppm : REFRESH_TOLERANCE_PPM;
+    int hstep = 1, hmax, vmax, dh, dv;
+    int best_dh = 0, best_dv = 0, best_cost = -1;
+    long long target, achieved, best_err = -1, err;
+
+    if (opts->dclk_pll == LCDPARAM_DCLK_NONE) {
+        return 0;
+    }
+
+    if (lcdparam_get_timing(data, &timing) < 0 || timing.clock == 0 || hactive <= 0 || vactive <= 0) {
+        /* left to lcdparam_check() to report */
+        return 0;
+    }
+
+    if (opts->refresh_mhz) {
+        target = opts->refresh_mhz;
+    } else if (opts->mode_vrefresh) {
+        target = opts->mode_vrefresh * 1000LL;
+    } else {
+        target = refresh_mhz(timing.clock, timing.htotal, timing.vtotal);
+    }
+    if (target <= 0) {
+        return 0;
+    }
+
+    /* dual lvds splits every line in two, keep horizontal timing even */
+    if (lcdparam_get(data, LCDPARAM_PANEL_TYPE) == PANEL_TYPE_LVDS
+        && lcdparam_get(data, LCDPARAM_LVDS_CHANNEL)) {
+        hstep = 2;
+    }
+    hmax = (timing.htotal - hactive) / 8;
+    hmax -= hmax % hstep;
+    vmax = (timing.vtotal - vactive) / 4;
+
+    for (dv = 0; dv <= 2 * vmax; dv++) {
+        int v = (dv & 1) ? -(dv + 1) / 2 : dv / 2;
+
+        if (vfp + v < (vfp ? 1 : 0)) {
+            continue;
+        }
+
+        for (dh = 0; dh <= 2 * hmax; dh += hstep) {
+            int h = ((dh / hstep) & 1) ? -(dh + hstep) / 2 : dh / 2;
+            int htotal = timing.htotal + h;
+            int vtotal = timing.vtotal + v;
+            int cost;
+
+            if (h % hstep || hfp + h < (hfp ? 1 : 0)) {
+                continue;
+            }
+
+            dclk_nearest(opts->dclk_pll,
+                         ((unsigned long long)target * htotal * vtotal + 500) / 1000, &cfg);
+            if (!cfg.rate) {
+                continue;
+            }
+
+            achieved = refresh_mhz(cfg.rate, htotal, vtotal);
+            err = error_ppm(achieved, target);
+            cost = abs(h) + abs(v) * 8;
+
+            if (err <= tolerance) {
+                if (best_cost < 0 || best_err > tolerance || cost < best_cost) {
+                    best_cost = cost;
+                    best_err = err;
+                    best_dh = h;
+                    best_dv = v;
+                    best_cfg = cfg;
+                }
+            } else if (best_err < 0 || (best_err > tolerance && err < best_err)) {
+                best_cost = cost;
+                best_err = err;
+                best_dh = h;
+                best_dv = v;
+                best_cfg = cfg;
+            }
+        }
+
+        /* more lines can only cost more once the rate is met */
+        if (best_err >= 0 && best_err <= tolerance && abs(v) * 8 > best_cost) {
+            break;
+        }
+    }
+
+    if (best_err < 0) {
+        LCDPARAM_LOGE("no dclk near %lu Hz can be generated", timing.clock);
+        return -1;
+    }
+
+    lcdparam_set(data, LCDPARAM_CLOCK_FREQUENCY, best_cfg.rate);
+    lcdparam_set(data, LCDPARAM_HFRONT_PORCH, hfp + best_dh);
+    lcdparam_set(data, LCDPARAM_VFRONT_PORCH, vfp + best_dv);
+
+    achieved = refresh_mhz(best_cfg.rate, timing.htotal + best_dh, timing.vtotal + best_dv);
+    if (best_cfg.nf) {
+        LCDPARAM_LOGI("dclk %llu Hz = 24MHz * %d / %d / %d / %d, hfront-porch %+d, vfront-porch %+d",
+                      best_cfg.rate, best_cfg.nf, best_cfg.nr, best_cfg.no, best_cfg.div,
+                      best_dh, best_dv);
+    } else {
+        LCDPARAM_LOGI("dclk %llu Hz = %s / %d, hfront-porch %+d, vfront-porch %+d",
+                      best_cfg.rate, opts->dclk_pll == LCDPARAM_DCLK_GPLL ? "gpll" : "cpll",
+                      best_cfg.div, best_dh, best_dv);
+    }
+    LCDPARAM_LOGI("refresh %lld mHz, target %lld mHz, error %lld ppm (tolerance %d ppm)",
+                  achieved, target, best_err, tolerance);
+
+    if (best_err > tolerance) {
+        LCDPARAM_LOGE("refresh error %lld ppm exceeds tolerance %d ppm", best_err, tolerance);
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,246 @@
+/*********************************************************************************
+* Copyright 2019 Bob Shen
+* FileName: lcdparam_seq.c
+* Author: Bob Shen
+* Version: 1.0.0
+* Date: 2019-3-14
+* Description:
+*     Check the panel-init-sequence framing of the rockchip panel driver,
+*     report how long it blocks the panel power on and, when asked for,
+*     drop repeated writes and clamp the delays to a per panel profile.
+*
+* Revision:
+*     Date:
+*     Reviser:
+*     Description:
+*********************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "lcdparam.h"
+
+/* every command is data type, delay in ms, payload length, payload */
+#define SEQ_HEADER_LEN              3
+
+/* mipi dsi data types of the rockchip panel driver */
+#define MIPI_DSI_GENERIC_SHORT_WRITE_0_PARAM    0x03
+#define MIPI_DSI_GENERIC_SHORT_WRITE_1_PARAM    0x13
+#define MIPI_DSI_GENERIC_SHORT_WRITE_2_PARAM    0x23
+#define MIPI_DSI_DCS_SHORT_WRITE                0x05
+#define MIPI_DSI_DCS_SHORT_WRITE_PARAM          0x15
+#define MIPI_DSI_GENERIC_LONG_WRITE             0x29
+#define MIPI_DSI_DCS_LONG_WRITE                 0x39
+
+/*
+ * Escape mode transfer estimate: 10MHz escape clock, spaced one hot coding
+ * takes two clocks per bit, plus the LP entry/exit of every packet.
+ */
+#define SEQ_BYTE_NS                 1600
+#define SEQ_PACKET_NS               10000
+
+struct seq_min_delay {
+    uint8 cmd;
+    uint8 delay;
+};
+
+/* used when the panel profile has no entry for a command */
+static const struct seq_min_delay seq_builtin_min[] = {
+    { 0x01, 120 },  // soft_reset
+    { 0x10, 120 },  // enter_sleep_mode
+    { 0x11, 120 },  // exit_sleep_mode
+    { 0x28, 20 },   // set_display_off
+    { 0x29, 20 },   // set_display_on
+};
+
+struct seq_stats {
+    int commands;
+    int delay_ms;
+    long long transfer_ns;
+};
+
+static int seq_long_packet(uint8 type)
+{
+    return type == MIPI_DSI_GENERIC_LONG_WRITE || type == MIPI_DSI_DCS_LONG_WRITE;
+}
+
+/* the first payload byte is a dcs command only in dcs packets */
+static int seq_dcs_type(uint8 type)
+{
+    return type == MIPI_DSI_DCS_SHORT_WRITE || type == MIPI_DSI_DCS_SHORT_WRITE_PARAM
+           || type == MIPI_DSI_DCS_LONG_WRITE;
+}
+
+static int seq_known_type(uint8 type)
+{
+    switch (type) {
+        case MIPI_DSI_GENERIC_SHORT_WRITE_0_PARAM:
+        case MIPI_DSI_GENERIC_SHORT_WRITE_1_PARAM:
+        case MIPI_DSI_GENERIC_SHORT_WRITE_2_PARAM:
+        case MIPI_DSI_DCS_SHORT_WRITE:
+        case MIPI_DSI_DCS_SHORT_WRITE_PARAM:
+        case MIPI_DSI_GENERIC_LONG_WRITE:
+        case MIPI_DSI_DCS_LONG_WRITE:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+* @decs: 检查命令分帧并统计延时和传输时间
+* @param: seq, len, stats
+* @return: 命令数 <0: 分帧错误
+*/
+static int seq_scan(const uint8 *seq, int len, struct seq_stats *stats)
+{
+    int pos = 0;
+
+    memset(stats, 0, sizeof(*stats));
+
+    while (pos < len) {
+        int plen;
+
+        if (pos + SEQ_HEADER_LEN > len) {
+            LCDPARAM_LOGE("panel-init-sequence: command %d at byte %d has a truncated header",
+                          stats->commands, pos);
+            return -1;
+        }
+        plen = seq[pos + 2];
+        if (plen == 0 || pos + SEQ_HEADER_LEN + plen > len) {
+            LCDPARAM_LOGE("panel-init-sequence: command %d at byte %d, payload length %d exceeds the sequence",
+                          stats->commands, pos, plen);
+            return -1;
+        }
+        if (!seq_known_type(seq[pos])) {
+            LCDPARAM_LOGW("panel-init-sequence: command %d at byte %d has unknown data type 0x%02x",
+                          stats->commands, pos, seq[pos]);
+        }
+
+        stats->commands++;
+        stats->delay_ms += seq[pos + 1];
+        stats->transfer_ns += SEQ_PACKET_NS
+                              + (long long)SEQ_BYTE_NS * (seq_long_packet(seq[pos]) ? 6 + plen : 4);
+        pos += SEQ_HEADER_LEN + plen;
+    }
+
+    return stats->commands;
+}
+
+static int seq_min_delay(const struct lcdparam_options *opts, uint8 cmd)
+{
+    int i;
+
+    for (i = 0; i < opts->seq_min_count; i++) {
+        if (opts->seq_min_cmd[i] == cmd) {
+            return opts->seq_min_delay[i];
+        }
+    }
+    if (opts->seq_min_default >= 0) {
+        return opts->seq_min_default;
+    }
+    for (i = 0; i < (int)(sizeof(seq_builtin_min) / sizeof(seq_builtin_min[0])); i++) {
+        if (seq_builtin_min[i].cmd == cmd) {
+            return seq_builtin_min[i].delay;
+        }
+    }
+
+    return -1;
+}
+
+/**
+* @decs: 去掉重复写入并按屏的延时下限收紧延时, 原地修改序列
+* @param: seq, len, opts
+* @return: 优化后的长度
+*/
+static int seq_optimize(uint8 *seq, int len, const struct lcdparam_options *opts)
+{
+    uint8 out[LCDPARAM_SEQ_MAX_LEN];
+    int prev = -1, olen = 0, pos = 0;
+    int merged = 0, clamped = 0;
+
+    while (pos < len) {
+        int clen = SEQ_HEADER_LEN + seq[pos + 2];
+        int delay = seq[pos + 1];
+        int min = -1;
+
+        /* generic writes carry a vendor register number, not a dcs command */
+        if (seq_dcs_type(seq[pos]) && seq[pos + 2] >= 1) {
+            min = seq_min_delay(opts, seq[pos + SEQ_HEADER_LEN]);
+        }
+
+        if (min >= 0 && delay > min) {
+            delay = min;
+            clamped++;
+        }
+
+        /*
+         * The same packet sent again right after itself leaves the panel
+         * in the same state, keep one write and the longer delay.
+         */
+        if (prev >= 0 && olen - prev == clen && out[prev] == seq[pos]
+            && !memcmp(&out[prev + 2], &seq[pos + 2], clen - 2)) {
+            if (delay > out[prev + 1]) {
+                out[prev + 1] = delay;
+            }
+            merged++;
+            pos += clen;
+            continue;
+        }
+
+        prev = olen;
+        memcpy(&out[olen], &seq[pos], clen);
+        out[olen + 1] = delay;
+        olen += clen;
+        pos += clen;
+    }
+
+    memcpy(seq, out, olen);
+    memset(seq + olen, 0, len - olen);
+    LCDPARAM_LOGI("panel-init-sequence: %d repeated write(s) merged, %d delay(s) clamped",
+                  merged, clamped);
+
+    return olen;
+}
+
+/**
+* @decs: 检查panel-init-sequence, 报告上电阻塞时间, 非verbatim模式下优化序列
+* @param: data, opts
+* @return: 0：success <0: 分帧错误
+*/
+int lcdparam_optimize_init_sequence(uint8 *data, const struct lcdparam_options *opts)
+{
+    uint8 *seq = data + LCDPARAM_SEQ_OFFSET;
+    int len = lcdparam_get(data, LCDPARAM_INIT_SEQUENCE);
+    int power_ms = lcdparam_get(data, LCDPARAM_PREPARE_DELAY) + lcdparam_get(data, LCDPARAM_RESET_DELAY)
+                   + lcdparam_get(data, LCDPARAM_INIT_DELAY) + lcdparam_get(data, LCDPARAM_ENABLE_DELAY);
+    struct seq_stats before, after;
+
+    if (len == 0) {
+        return 0;
+    }
+    if (seq_scan(seq, len, &before) < 0) {
+        return -1;
+    }
+
+    LCDPARAM_LOGI("panel-init-sequence: %d commands, %d bytes, %d ms delay, %lld us transfer",
+                  before.commands, len, before.delay_ms, before.transfer_ns / 1000);
+
+    if (opts->seq_mode == LCDPARAM_SEQ_VERBATIM) {
+        LCDPARAM_LOGI("panel bring-up estimate %lld ms (init-sequence-mode = verbatim)",
+                      power_ms + before.delay_ms + before.transfer_ns / 1000000);
+        return 0;
+    }
+
+    len = seq_optimize(seq, len, opts);
+    lcdparam_set(data, LCDPARAM_INIT_SEQUENCE, len);
+    seq_scan(seq, len, &after);
+
+    LCDPARAM_LOGI("panel-init-sequence: %d commands, %d bytes, %d ms delay, %lld us transfer",
+                  after.commands, len, after.delay_ms, after.transfer_ns / 1000);
+    LCDPARAM_LOGI("panel bring-up estimate %lld ms -> %lld ms",
+                  power_ms + before.delay_ms + before.transfer_ns / 1000000,
+                  power_ms + after.delay_ms + after.transfer_ns / 1000000);
+
+    return 0;
+}
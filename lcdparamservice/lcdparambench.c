@@ -0,0 +1,605 @@
+/*********************************************************************************
+* Copyright 2019 Bob Shen
+* FileName: lcdparambench.c
+* Author: Bob Shen
+* Version: 1.0.0
+* Date: 2019-3-14
+* Description:
+*     Host benchmark of the u-boot display helpers that build without u-boot,
+*     against what they replace: the phandle index against
+*     fdt_node_offset_by_phandle() of libfdt on synthetic blobs, the palette
+*     bmp decoder against a per pixel decoder on generated bmps.
+*
+* Revision:
+*     Date:
+*     Reviser:
+*     Description:
+*********************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <time.h>
+#include <libfdt.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+
+#include "rockchip_phandle.h"
+#include "rockchip_bmp.h"
+
+#define BENCH_ROUNDS                5
+
+static void help()
+{
+    printf("USAGE: lcdparambench phandle [-n nodes] [-l lookups]\n");
+    printf("       lcdparambench bmp [-o dir]\n");
+    printf("WHERE: -n = nodes with a phandle in the synthetic dtb, 500, 2000\n");
+    printf("            and 10000 by default\n");
+    printf("       -l = phandle lookups per boot, 64 by default, about what the\n");
+    printf("            display graph of two routes resolves\n");
+    printf("       -o = also write the generated bmps to dir\n\n");
+}
+
+static unsigned long bench_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+/**
+* @decs: 生成nodes个带phandle的节点的dtb, phandle顺序随机打乱, 与dtc及overlay
+*        分配的phandle一样不随offset递增. 每个节点带一个无phandle的port子节点
+* @param: nodes, size
+* @return: blob, NULL: failed
+*/
+static void *bench_make_dtb(int nodes, int *size)
+{
+    int bufsize = 256 + nodes * 160;
+    u32 *phandles;
+    char name[32];
+    void *fdt;
+    int i, j, ret = 0;
+    u32 tmp;
+
+    fdt = malloc(bufsize);
+    phandles = malloc(sizeof(*phandles) * nodes);
+    if (!fdt || !phandles) {
+        free(fdt);
+        free(phandles);
+        return NULL;
+    }
+
+    for (i = 0; i < nodes; i++) {
+        phandles[i] = i + 1;
+    }
+    for (i = nodes - 1; i > 0; i--) {
+        j = rand() % (i + 1);
+        tmp = phandles[i];
+        phandles[i] = phandles[j];
+        phandles[j] = tmp;
+    }
+
+    ret |= fdt_create(fdt, bufsize);
+    ret |= fdt_finish_reservemap(fdt);
+    ret |= fdt_begin_node(fdt, "");
+    for (i = 0; i < nodes && !ret; i++) {
+        snprintf(name, sizeof(name), "dev@%x", 0xff000000 + i * 0x1000);
+        ret |= fdt_begin_node(fdt, name);
+        ret |= fdt_property_string(fdt, "compatible", "rockchip,bench");
+        ret |= fdt_property_u32(fdt, "reg", 0xff000000 + i * 0x1000);
+        ret |= fdt_property_u32(fdt, "phandle", phandles[i]);
+        ret |= fdt_begin_node(fdt, "port");
+        ret |= fdt_property_u32(fdt, "remote-endpoint", phandles[rand() % nodes]);
+        ret |= fdt_end_node(fdt);
+        ret |= fdt_end_node(fdt);
+    }
+    ret |= fdt_end_node(fdt);
+    ret |= fdt_finish(fdt);
+    free(phandles);
+
+    if (ret) {
+        printf("dtb of %d nodes does not fit %d bytes\n", nodes, bufsize);
+        free(fdt);
+        return NULL;
+    }
+
+    *size = fdt_totalsize(fdt);
+    return fdt;
+}
+
+/**
+* @decs: 对比phandle索引与fdt_node_offset_by_phandle()的结果和耗时, 结果必须
+*        对每个phandle都相同. 耗时取BENCH_ROUNDS轮中最短的一轮
+* @param: nodes, lookups
+* @return: 0：success <0: failed
+*/
+static int bench_phandle(int nodes, int lookups)
+{
+    struct rockchip_phandle_index index = { NULL, 0, NULL };
+    unsigned long build_us = -1UL, index_us = -1UL, fdt_us = -1UL, start;
+    u32 *wanted;
+    void *fdt;
+    int size, round, i, sum = 0;
+
+    fdt = bench_make_dtb(nodes, &size);
+    wanted = malloc(sizeof(*wanted) * lookups);
+    if (!fdt || !wanted) {
+        free(fdt);
+        free(wanted);
+        return -1;
+    }
+    for (i = 0; i < lookups; i++) {
+        wanted[i] = 1 + rand() % nodes;
+    }
+
+    for (round = 0; round < BENCH_ROUNDS; round++) {
+        start = bench_us();
+        if (rockchip_phandle_index_build(&index, fdt)) {
+            printf("index of %d nodes failed\n", nodes);
+            free(fdt);
+            free(wanted);
+            return -1;
+        }
+        start = bench_us() - start;
+        build_us = start < build_us ? start : build_us;
+
+        start = bench_us();
+        for (i = 0; i < lookups; i++) {
+            sum += rockchip_phandle_index_lookup(&index, wanted[i]);
+        }
+        start = bench_us() - start;
+        index_us = start < index_us ? start : index_us;
+
+        start = bench_us();
+        for (i = 0; i < lookups; i++) {
+            sum -= fdt_node_offset_by_phandle(fdt, wanted[i]);
+        }
+        start = bench_us() - start;
+        fdt_us = start < fdt_us ? start : fdt_us;
+    }
+
+    /* every phandle, one past the last and the invalid ones */
+    for (i = 0; i <= nodes + 1 && sum == 0; i++) {
+        if (rockchip_phandle_index_lookup(&index, i) != fdt_node_offset_by_phandle(fdt, i)) {
+            sum = 1;
+        }
+    }
+    if (sum == 0 && rockchip_phandle_index_lookup(&index, (u32)-1)
+        != fdt_node_offset_by_phandle(fdt, (u32)-1)) {
+        sum = 1;
+    }
+    rockchip_phandle_index_free(&index);
+    free(fdt);
+    free(wanted);
+
+    if (sum) {
+        printf("%d nodes: index and fdt_node_offset_by_phandle() differ\n", nodes);
+        return -1;
+    }
+
+    printf("%6d nodes, dtb %4d KB: build %6lu us + %d lookups %4lu us, "
+           "fdt_node_offset_by_phandle %8lu us\n",
+           nodes, size / 1024, build_us, lookups, index_us, fdt_us);
+
+    return 0;
+}
+
+struct bench_bmp {
+    int width;
+    int height;
+    int bpp;
+    int compression;            /* 0 rgb, 1 rle8, 2 rle4 */
+    int top_down;
+};
+
+/* odd widths and row paddings first, then logo sized ones for the timing */
+static const struct bench_bmp bench_bmps[] = {
+    { 37, 23, 8, 0, 0 },
+    { 64, 16, 8, 0, 1 },
+    { 33, 9, 4, 0, 0 },
+    { 21, 13, 1, 0, 0 },
+    { 70, 5, 1, 0, 1 },
+    { 41, 19, 8, 1, 0 },
+    { 29, 17, 4, 2, 0 },
+    { 1280, 800, 8, 0, 0 },
+    { 1280, 800, 4, 0, 0 },
+    { 1280, 800, 1, 0, 0 },
+    { 1280, 800, 8, 1, 0 },
+    { 1280, 800, 4, 2, 0 },
+};
+
+static void put_le16(u8 *p, u32 v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void put_le32(u8 *p, u32 v)
+{
+    put_le16(p, v);
+    put_le16(p + 2, v >> 16);
+}
+
+static u16 bench_rgb565(const u8 *bgrx)
+{
+    return (bgrx[2] >> 3) << 11 | (bgrx[1] >> 2) << 5 | bgrx[0] >> 3;
+}
+
+/*
+ * One rle row of idx[0..limit), with a delta over 3 pixels at the first
+ * run boundary from *skip on. *skip returns where, -1 when there is none.
+ */
+static int bench_rle_row(u8 *out, const u8 *idx, int limit, int *skip, int bpp)
+{
+    int len = 0, x = 0, run, n, i, want = *skip;
+
+    *skip = -1;
+    while (x < limit) {
+        if (want >= 0 && x >= want && x + 3 < limit) {
+            *skip = x;
+            want = -1;
+            out[len++] = 0;
+            out[len++] = 2;
+            out[len++] = 3;
+            out[len++] = 0;
+            x += 3;
+            continue;
+        }
+
+        /* rle4 runs repeat the pair of the first two pixels */
+        for (run = 1; x + run < limit && run < 255; run++) {
+            if (idx[x + run] != idx[x + (bpp == 8 ? 0 : run % 2)]) {
+                break;
+            }
+        }
+        if (run >= 3 || limit - x < 3) {
+            out[len++] = run;
+            out[len++] = bpp == 8 ? idx[x] : idx[x] << 4 | (run > 1 ? idx[x + 1] : 0);
+            x += run;
+            continue;
+        }
+
+        n = 3 + rand() % 18;
+        n = n < limit - x ? n : limit - x;
+        out[len++] = 0;
+        out[len++] = n;
+        for (i = 0; i < n; i += bpp == 8 ? 1 : 2) {
+            out[len++] = bpp == 8 ? idx[x + i] : idx[x + i] << 4 | (i + 1 < n ? idx[x + i + 1] : 0);
+        }
+        if (len & 1) {
+            out[len++] = 0;
+        }
+        x += n;
+    }
+    out[len++] = 0;
+    out[len++] = 0;
+
+    return len;
+}
+
+/**
+* @decs: 生成一个bmp及其rgb565的期望输出(自上而下). 图像由随机像素和重复的
+*        像素段组成, rle的部分行以行结束提前结束, 部分行含delta跳过,
+*        未写到的像素期望为0
+* @param: b, size, expect
+* @return: bmp, 大小按512字节块对齐补0, NULL: failed
+*/
+static u8 *bench_make_bmp(const struct bench_bmp *b, u32 *size, u16 **expect)
+{
+    int colors = 1 << b->bpp;
+    int stride = ((b->width * b->bpp + 31) / 32) * 4;
+    int rle_max = b->height * (b->width * 2 + 8) + 2;
+    int data_offset = 54 + colors * 4;
+    int row, x, y, limit, skip, len = 0;
+    u8 *bmp, *idx, *pal, *data, *line;
+    u16 *exp;
+    u32 cap;
+
+    cap = data_offset + (b->compression ? rle_max : stride * b->height);
+    cap = (cap + ROCKCHIP_BMP_BLK_SIZE - 1) & ~(ROCKCHIP_BMP_BLK_SIZE - 1);
+    bmp = calloc(1, cap);
+    idx = malloc(b->width * b->height);
+    exp = calloc(b->width * b->height, sizeof(*exp));
+    if (!bmp || !idx || !exp) {
+        free(bmp);
+        free(idx);
+        free(exp);
+        return NULL;
+    }
+
+    pal = bmp + 54;
+    for (x = 0; x < colors * 4; x++) {
+        pal[x] = (x & 3) == 3 ? 0 : rand();
+    }
+    for (y = 0; y < b->height; y++) {
+        for (x = 0; x < b->width; x++) {
+            idx[y * b->width + x] = rand() % 10 < 3 ? rand() % colors : (x / 5) % colors;
+        }
+    }
+
+    data = bmp + data_offset;
+    for (row = 0; row < b->height; row++) {
+        /* y counts from the top, the file rows from the bottom unless top down */
+        y = b->top_down ? row : b->height - 1 - row;
+        line = idx + y * b->width;
+        limit = b->width;
+
+        if (b->compression) {
+            if (row % 7 == 3) {
+                limit = b->width / 2;
+            }
+            skip = row % 11 == 5 ? b->width / 4 : -1;
+            len += bench_rle_row(data + len, line, limit, &skip, b->bpp);
+        } else {
+            skip = -1;
+            for (x = 0; x < b->width; x++) {
+                data[row * stride + x * b->bpp / 8] |=
+                    line[x] << (8 - b->bpp - (x * b->bpp) % 8);
+            }
+        }
+
+        for (x = 0; x < limit; x++) {
+            if (skip < 0 || x < skip || x >= skip + 3) {
+                exp[y * b->width + x] = bench_rgb565(pal + line[x] * 4);
+            }
+        }
+    }
+    if (b->compression) {
+        data[len++] = 0;
+        data[len++] = 1;
+    } else {
+        len = stride * b->height;
+    }
+    free(idx);
+
+    bmp[0] = 'B';
+    bmp[1] = 'M';
+    put_le32(bmp + 2, data_offset + len);
+    put_le32(bmp + 10, data_offset);
+    put_le32(bmp + 14, 40);
+    put_le32(bmp + 18, b->width);
+    put_le32(bmp + 22, b->top_down ? -b->height : b->height);
+    put_le16(bmp + 26, 1);
+    put_le16(bmp + 28, b->bpp);
+    put_le32(bmp + 30, b->compression);
+    put_le32(bmp + 34, len);
+    put_le32(bmp + 46, colors);
+
+    *size = data_offset + len;
+    *expect = exp;
+    return bmp;
+}
+
+/*
+ * Per pixel decoder, the way bmpdecoder() walks a palettized bmp: every
+ * pixel indexes the bmp palette and is converted on its own. Reference
+ * for the output and the timing of rockchip_bmp_decode().
+ */
+static void bench_decode_reference(const u8 *bmp, u16 *dst)
+{
+    const u8 *pal = bmp + 14 + bmp[14];
+    const u8 *data = bmp + (bmp[10] | bmp[11] << 8 | bmp[12] << 16);
+    int width = bmp[18] | bmp[19] << 8;
+    int height = (int32_t)(bmp[22] | bmp[23] << 8 | bmp[24] << 16 | (u32)bmp[25] << 24);
+    int bpp = bmp[28], compression = bmp[30];
+    int stride = ((width * bpp + 31) / 32) * 4;
+    int top_down = height < 0, x = 0, y, row = 0, i, v;
+
+    height = top_down ? -height : height;
+    memset(dst, 0, width * height * sizeof(*dst));
+
+    if (!compression) {
+        for (row = 0; row < height; row++) {
+            y = top_down ? row : height - 1 - row;
+            for (x = 0; x < width; x++) {
+                v = data[row * stride + x * bpp / 8] >> (8 - bpp - (x * bpp) % 8);
+                dst[y * width + x] = bench_rgb565(pal + (v & ((1 << bpp) - 1)) * 4);
+            }
+        }
+        return;
+    }
+
+    while (row < height) {
+        u8 a = *data++, b = *data++;
+
+        y = height - 1 - row;
+        if (a) {
+            for (i = 0; i < a; i++, x++) {
+                v = bpp == 8 ? b : (i % 2 ? b & 0xf : b >> 4);
+                if (x < width) {
+                    dst[y * width + x] = bench_rgb565(pal + v * 4);
+                }
+            }
+        } else if (b == 0) {
+            x = 0;
+            row++;
+        } else if (b == 1) {
+            break;
+        } else if (b == 2) {
+            x += data[0];
+            row += data[1];
+            data += 2;
+        } else {
+            for (i = 0; i < b; i++, x++) {
+                v = bpp == 8 ? data[i] : (i % 2 ? data[i / 2] & 0xf : data[i / 2] >> 4);
+                if (x < width) {
+                    dst[y * width + x] = bench_rgb565(pal + v * 4);
+                }
+            }
+            data += ((bpp == 8 ? b : (b + 1) / 2) + 1) & ~1;
+        }
+    }
+}
+
+struct bench_stream {
+    const u8 *file;
+    int reads;
+};
+
+static int bench_read(void *priv, u32 block, void *buf, u32 blocks)
+{
+    struct bench_stream *stream = priv;
+
+    memcpy(buf, stream->file + block * ROCKCHIP_BMP_BLK_SIZE, blocks * ROCKCHIP_BMP_BLK_SIZE);
+    stream->reads++;
+    return 0;
+}
+
+/**
+* @decs: 解码一个生成的bmp: 整个文件在内存中, 经band流式读取, 以及逐像素的
+*        参考解码, 三者都必须与期望输出逐位相同. 耗时取BENCH_ROUNDS轮中最短的
+* @param: b, dir
+* @return: 0：success <0: failed
+*/
+static int bench_bmp(const struct bench_bmp *b, const char *dir)
+{
+    static const char *names[] = { "rgb", "rle8", "rle4" };
+    unsigned long mem_us = -1UL, stream_us = -1UL, ref_us = -1UL, start;
+    struct rockchip_bmp_src src;
+    struct bench_stream stream;
+    u16 *expect, *out, *ref;
+    char path[256];
+    u8 *bmp, *band;
+    int pixels = b->width * b->height, round, ret = 0, bad = 0;
+    FILE *fp;
+    u32 size;
+
+    bmp = bench_make_bmp(b, &size, &expect);
+    if (!bmp) {
+        return -1;
+    }
+    out = malloc(pixels * sizeof(*out));
+    ref = malloc(pixels * sizeof(*ref));
+    band = malloc(ROCKCHIP_BMP_BAND_SIZE);
+    if (!out || !ref || !band) {
+        ret = -1;
+        goto out;
+    }
+
+    snprintf(path, sizeof(path), "%s/bench_%dx%d_%d%s%s.bmp", dir ? dir : ".", b->width,
+             b->height, b->bpp, names[b->compression], b->top_down ? "_top_down" : "");
+    if (dir) {
+        fp = fopen(path, "wb");
+        if (fp == NULL || fwrite(bmp, 1, size, fp) != size) {
+            printf("write %s failed\n", path);
+            ret = -1;
+        }
+        if (fp) {
+            fclose(fp);
+        }
+    }
+
+    for (round = 0; round < BENCH_ROUNDS && !ret && !bad; round++) {
+        memset(&src, 0, sizeof(src));
+        src.mem = bmp;
+        src.size = size;
+        memset(out, 0xff, pixels * sizeof(*out));
+        start = bench_us();
+        ret |= rockchip_bmp_decode(&src, out);
+        start = bench_us() - start;
+        mem_us = start < mem_us ? start : mem_us;
+        bad |= memcmp(out, expect, pixels * sizeof(*out)) ? 1 : 0;
+
+        memset(&src, 0, sizeof(src));
+        stream.file = bmp;
+        stream.reads = 0;
+        src.size = size;
+        src.read = bench_read;
+        src.priv = &stream;
+        src.band = band;
+        memset(out, 0xff, pixels * sizeof(*out));
+        start = bench_us();
+        ret |= rockchip_bmp_decode(&src, out);
+        start = bench_us() - start;
+        stream_us = start < stream_us ? start : stream_us;
+        bad |= memcmp(out, expect, pixels * sizeof(*out)) ? 2 : 0;
+
+        memset(ref, 0xff, pixels * sizeof(*ref));
+        start = bench_us();
+        bench_decode_reference(bmp, ref);
+        start = bench_us() - start;
+        ref_us = start < ref_us ? start : ref_us;
+        bad |= memcmp(ref, expect, pixels * sizeof(*ref)) ? 4 : 0;
+    }
+
+    if (ret || bad) {
+        printf("%s: %s%s%s%s\n", path + (dir ? 0 : 2), ret ? "decoding failed" : "differs:",
+               bad & 1 ? " rockchip_bmp_decode()" : "", bad & 2 ? " streamed" : "",
+               bad & 4 ? " reference" : "");
+        ret = -1;
+    } else {
+        printf("%4dx%-4d %d bpp %-4s %s: %6lu us, streamed %6lu us in %2d reads, "
+               "per pixel %6lu us\n", b->width, b->height, b->bpp, names[b->compression],
+               b->top_down ? "top down " : "bottom up", mem_us, stream_us, stream.reads, ref_us);
+    }
+
+out:
+    free(bmp);
+    free(expect);
+    free(out);
+    free(ref);
+    free(band);
+    return ret;
+}
+
+int main(int argc, char * argv[])
+{
+    int defaults[] = { 500, 2000, 10000 };
+    int nodes = 0, lookups = 64;
+    char *dir = NULL;
+    int ch, i, ret = 0;
+
+    if (argc < 2 || (strcmp(argv[1], "phandle") && strcmp(argv[1], "bmp"))) {
+        help();
+        return -1;
+    }
+    optind = 2;
+
+    while ((ch = getopt(argc, argv, "n:l:o:h")) != -1) {
+        switch (ch) {
+            case 'n':
+                nodes = atoi(optarg);
+                break;
+
+            case 'l':
+                lookups = atoi(optarg);
+                break;
+
+            case 'o':
+                dir = optarg;
+                break;
+
+            case 'h':
+            default:
+                help();
+                return -1;
+        }
+    }
+    if (nodes < 0 || lookups <= 0) {
+        help();
+        return -1;
+    }
+
+    srand(1);
+    if (!strcmp(argv[1], "bmp")) {
+        for (i = 0; i < (int)(sizeof(bench_bmps) / sizeof(bench_bmps[0])); i++) {
+            ret |= bench_bmp(&bench_bmps[i], dir);
+        }
+        return ret;
+    }
+
+    if (nodes) {
+        return bench_phandle(nodes, lookups);
+    }
+    for (i = 0; i < (int)(sizeof(defaults) / sizeof(defaults[0])); i++) {
+        ret |= bench_phandle(defaults[i], lookups);
+    }
+
+    return ret;
+}
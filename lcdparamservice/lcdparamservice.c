@@ -22,9 +22,11 @@
 #include <stdio.h>
 #include <sys/ioctl.h>
 #include <sys/time.h>
+#include <sys/stat.h>
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <libgen.h>
 #include <cutils/properties.h>
 #include <sys/utsname.h>
 #include <cutils/list.h>
@@ -35,74 +37,41 @@
 
 #define LOG_TAG "LcdParamService"
 
-typedef unsigned short uint16;
-typedef unsigned long uint32;
-typedef unsigned char uint8;
+#include "lcdparam.h"
 
-#define LCDPARAM_FILE_PATH              "busybox find  /mnt/media_rw/ -name lcd_parameters"
+#define LCDPARAM_MEDIA_PATH             "/mnt/media_rw/"
+#define LCDPARAM_MEDIA_FIND             "busybox find  " LCDPARAM_MEDIA_PATH " -name lcd_parameters" \
+                                        " -o -name " LCDPARAM_CATALOG_NAME " -o -name '*.edid'" \
+                                        " -o -name " LCDPARAM_LOGO_NAME
+#define LCDPARAM_MEDIA_RESCAN_US        5000000 // walk a mounted media again after 5s
 #define LCDPARAM_PARTITIOM_NODE_PATH    "/dev/block/platform/ff0f0000.dwmmc/by-name/lcdparam"
-#define LCDPARAM_STORGAE_DATA_LEN       2048 // lcdparam size
-
-#define CRC_POLY                        0xEDB88320L // CRC stand
-#define CONFIG_MAX                      34
-
-char *key[CONFIG_MAX] = {
-    "panel-type",  //1
-
-    "unprepare-delay-ms",
-    "enable-delay-ms",
-    "disable-delay-ms",
-    "prepare-delay-ms",
-    "reset-delay-ms",
-    "init-delay-ms",
-    "width-mm",
-    "height-mm",
-
-    "clock-frequency", //10
-    "hactive",
-    "hfront-porch",
-    "hsync-len",
-    "hback-porch",
-    "vactive",
-    "vfront-porch",
-    "vsync-len",
-    "vback-porch",
-    "hsync-active",
-    "vsync-active", // 20
-    "de-active",
-    "pixelclk-active",
-
-    "uboot-init",
-
-    "lvds,format",
-    "lvds,mode",
-    "lvds,width",
-    "lvds,channel",
-
-    "dsi,lane-rate",
-    "dsi,flags",
-    "dsi,format",
-    "dsi,lanes",
-
-    "orientation",
-    "density",
-
-    "panel-init-sequence"
-};
 
-typedef struct {
-    unsigned char data[LCDPARAM_STORGAE_DATA_LEN];
-} LCDPARAM_STORGAE_T;
+#define LCDPARAM_TIMELINE_PATH          "/proc/device-tree/chosen/rockchip,display-timeline"
+#define LCDPARAM_TIMELINE_NAMES_PATH    "/proc/device-tree/chosen/rockchip,display-timeline-names"
+#define LCDPARAM_TIMELINE_PROPERTY      "sys.lcdparam.boot_display_us"
+
+#define LCDPARAM_SERIAL_PROPERTY        "ro.serialno"
+#define LCDPARAM_BOARD_PROPERTY         "ro.boot.lcdparam.board"
 
 enum {
     OPT_SCAN,
     OPT_READ,
-    OPT_WRITE
+    OPT_WRITE,
+    OPT_CHECK
 };
 
-static uint32 crc32_tab[256];
 static uint32 nand_crc = 0;
 
+/* first match of each name in the last walk of the media, "" if none */
+struct media_files {
+    char params[128];
+    char catalog[128];
+    char edid[128];
+    char logo[128];
+};
+
+static struct media_files media;
+
 char *strreplace(char *s, char old, char new)
 {
     for (; *s; ++s) {
@@ -122,153 +91,6 @@ void rknand_print_hex_data(uint8 *s, uint32 * buf, uint32 len)
     }
 }
 
-void init_crc32_tab(void)
-{
-    int i = 0;
-    int j = 0;
-    uint32 crc = 0;
-
-    for (i = 0; i < 256; i++) {
-        crc = (uint32)i;
-        for (j = 0; j < 8; j++) {
-            if (crc & 0x00000001L) {
-                crc = (crc >> 1) ^ CRC_POLY;
-            } else {
-                crc = crc >> 1;
-            }
-        }
-        crc32_tab[i] = crc;
-    }
-}
-
-uint32 get_crc32(uint32 crc_init, uint8 *crc_buf, uint32 buf_size)
-{
-    uint32 crc = crc_init ^ 0xffffffff;
-
-    init_crc32_tab();
-    while (buf_size--) {
-        crc = (crc >> 8) ^ crc32_tab[(crc & 0xff) ^ *crc_buf++];
-    }
-    return crc ^ 0xfffffff;
-}
-
-uint32 getfile_crc(FILE *fp)
-{
-    uint32 size = 4 * 1024;
-    uint8 crc_buf[size];
-    uint32 readln = 0;
-    uint crc = 0;
-
-    while ((readln = fread(crc_buf, sizeof(uint8), size, fp)) > 0) {
-        crc = get_crc32(crc, crc_buf, readln);
-    }
-
-    return crc;
-}
-
-/**
-* @decs:去除字符串左端空格
-* @param: pstr
-* @return: char *
-*/
-char *strtriml(char *pstr)
-{
-    int i = 0, j;
-    j = strlen(pstr) - 1;
-    while (isspace(pstr[i]) && (i <= j)) {
-        i++;
-    }
-    if (0 < i) {
-        strcpy(pstr, &pstr[i]);
-    }
-    return pstr;
-}
-
-/**
-* @decs:去除字符串右端空格
-* @param: pstr
-* @return: char *
-*/
-char *strtrimr(char *pstr)
-{
-    int i;
-    i = strlen(pstr) - 1;
-    while (isspace(pstr[i]) && (i >= 0)) {
-        pstr[i--] = '\0';
-    }
-    return pstr;
-}
-
-
-/**
-* @decs:去除字符串两端空格
-* @param: pstr
-* @return: char *
-*/
-char *strtrim(char *pstr)
-{
-    char *p;
-    p = strtrimr(pstr);
-    return strtriml(p);
-}
-
-
-char *strdelchr(char *pstr, int chr)
-{
-    int i = 0;
-    int l = 0;
-    int ll = 0;
-    ll = l = strlen(pstr);
-
-    while (i < l) {
-        if (pstr[i] == chr) {
-            memmove((pstr + i), (pstr + i + 1), (ll - i - 1));
-            pstr[ll - 1] = '\0';
-            ll--;
-        }
-        i++;
-    }
-    return pstr;
-}
-
-
-void strrmspace(char * str)
-{
-    char *p1, *p2;
-    char ch;
-    p1 = str; //first pointer
-    p2 = str; //second pointer to the remaining string
-
-    if (p1 == NULL) {
-        return;
-    }
-
-    while (*p1) {
-        if (*p1 != ' ') {
-            ch = *p1;
-            *p2 = ch;
-            p1++;
-            p2++;
-        } else {
-            p1++;
-        }
-    }
-    *p2 = '\0';
-}
-
-int key2Index(char *k)
-{
-    int i;
-
-    for (i = 0; i < CONFIG_MAX; i++) {
-        if (strstr(k, key[i])) {
-            return i;
-        }
-    }
-
-    return -1;
-}
-
 void sync_properties(char *key, char *value) {
     if (strcmp(key, "orientation") == 0) {
         if (strcmp(value, "0") == 0 || strcmp(value, "90") == 0
@@ -320,10 +142,7 @@ uint32 read_param_from_nand(char *k)
         return -1;
     }
 
-    value = sysData.data[keyIndex * 4];
-    value = (value << 8) + sysData.data[keyIndex * 4 + 1];
-    value = (value << 8) + sysData.data[keyIndex * 4 + 2];
-    value = (value << 8) + sysData.data[keyIndex * 4 + 3];
+    value = lcdparam_get(sysData.data, keyIndex);
 
     close(sys_fd);
 
@@ -340,7 +159,7 @@ uint32 write_param_to_nand(char *k, char *v)
     int ret = 0;
     int keyIndex = key2Index(k);
     uint32 value = atoi(v);
-    unsigned char data[4];
+    LCDPARAM_STORGAE_T sysData;
     int sys_fd;
 
     if (keyIndex < 0 || keyIndex >= CONFIG_MAX) {
@@ -353,20 +172,30 @@ uint32 write_param_to_nand(char *k, char *v)
         return -1;
     }
 
-    sys_fd = open(LCDPARAM_PARTITIOM_NODE_PATH, O_WRONLY);
+    sys_fd = open(LCDPARAM_PARTITIOM_NODE_PATH, O_RDWR);
     if (sys_fd < 0) {
         ALOGE("%s, open %s failed, err=%d\n", __func__, LCDPARAM_PARTITIOM_NODE_PATH, sys_fd);
         return -1;
     }
 
-    data[0] = (uint8)(value >> 24);
-    data[1] = (uint8)(value >> 16);
-    data[2] = (uint8)(value >> 8);
-    data[3] = (uint8)(value >> 0);
+    ret = read(sys_fd, (void*)&sysData, sizeof(sysData));
+    if (ret < 0) {
+        ALOGE("%s, read %s failed, err=%d\n", __func__, LCDPARAM_PARTITIOM_NODE_PATH, sys_fd);
+        close(sys_fd);
+        return -1;
+    }
+
+    lcdparam_set(sysData.data, keyIndex, value);
+    if (lcdparam_check_edit(sysData.data, keyIndex) < 0) {
+        ALOGE("%s, %s=%s rejected, lcdparam partition not changed\n", __func__, key[keyIndex], v);
+        close(sys_fd);
+        return -1;
+    }
 
-    ret = pwrite(sys_fd, (void*)&data[0], 4, keyIndex * 4);
+    ret = pwrite(sys_fd, (void*)&sysData.data[lcdparam_offset(keyIndex)], 4, lcdparam_offset(keyIndex));
     if (ret < 0) {
         ALOGE("%s, write %s failed, err=%d\n", __func__, LCDPARAM_PARTITIOM_NODE_PATH, sys_fd);
+        close(sys_fd);
         return -1;
     }
 
@@ -406,15 +235,13 @@ uint32  getfile_crc_from_nand(void)
         return -1;
     }
 
-    for (int i = 0; i < CONFIG_MAX + 1; i++) {
-        crc = sysData.data[i * 4];
-        crc = (crc << 8) + sysData.data[i * 4 + 1];
-        crc = (crc << 8) + sysData.data[i * 4 + 2];
-        crc = (crc << 8) + sysData.data[i * 4 + 3];
-        ALOGE("%s, %d nand data = 0X%02X%02X%02X%02X", __func__, i, sysData.data[i * 4],
-              sysData.data[i * 4 + 1],
-              sysData.data[i * 4 + 2],
-              sysData.data[i * 4 + 3]);
+    for (int i = 0; i < CONFIG_MAX; i++) {
+        int off = lcdparam_offset(i);
+
+        ALOGE("%s, %d nand data = 0X%02X%02X%02X%02X", __func__, i, sysData.data[off],
+              sysData.data[off + 1],
+              sysData.data[off + 2],
+              sysData.data[off + 3]);
     }
 
     crc = sysData.data[LCDPARAM_STORGAE_DATA_LEN - 4];
@@ -430,6 +257,317 @@ uint32  getfile_crc_from_nand(void)
     return crc;
 }
 
+/**
+* @decs: 从屏参数据库中选择屏参, 优先按名字, 其次按序列号区间, 最后按板号
+* @param: path, profile, data
+* @return: 0：success <0: failed
+*/
+int load_catalog_profile(const char *path, const char *profile, uint8 *data)
+{
+    struct lcdparam_catalog cat;
+    const uint8 *blob = NULL;
+    char prop[PROPERTY_VALUE_MAX];
+
+    if (lcdparam_catalog_open(&cat, path) < 0) {
+        return -1;
+    }
+
+    if (profile && profile[0]) {
+        blob = lcdparam_catalog_find(&cat, profile);
+        ALOGE("%s, profile %s %s", __func__, profile, blob ? "found" : "not found");
+    } else {
+        property_get(LCDPARAM_SERIAL_PROPERTY, prop, "");
+        if (prop[0]) {
+            blob = lcdparam_catalog_find_serial(&cat, prop);
+            ALOGE("%s, serial %s %s", __func__, prop, blob ? "found" : "not found");
+        }
+        if (!blob) {
+            property_get(LCDPARAM_BOARD_PROPERTY, prop, "");
+            if (prop[0]) {
+                blob = lcdparam_catalog_find_board(&cat, prop);
+                ALOGE("%s, board %s %s", __func__, prop, blob ? "found" : "not found");
+            }
+        }
+    }
+
+    if (blob) {
+        memcpy(data, blob, LCDPARAM_STORGAE_DATA_LEN);
+    }
+    lcdparam_catalog_close(&cat);
+
+    return blob ? 0 : -1;
+}
+
+/**
+* @decs: 解析并检查lcd_parameters文件或屏参数据库, 生成含crc的分区数据
+* @param: path, data
+* @return: 0：success <0: failed
+*/
+int check_lcd_parameters(const char *path, uint8 *data)
+{
+    struct lcdparam_options opts;
+    char catalog[256];
+    FILE *fp;
+    int ret;
+
+    if (strstr(path, LCDPARAM_CATALOG_NAME)) {
+        ret = load_catalog_profile(path, NULL, data);
+    } else {
+        fp = fopen(path, "r");
+        if (fp == NULL) {
+            ALOGE("%s, open %s failed", __func__, path);
+            return -1;
+        }
+
+        ret = lcdparam_parse(fp, path, data, &opts);
+        if (ret == 0 && opts.profile[0]) {
+            /* the catalog is next to lcd_parameters */
+            strncpy(catalog, path, sizeof(catalog) - 1);
+            catalog[sizeof(catalog) - 1] = '\0';
+            snprintf(catalog, sizeof(catalog), "%s/%s", dirname(catalog), LCDPARAM_CATALOG_NAME);
+            ret = load_catalog_profile(catalog, opts.profile, data);
+        } else if (ret == 0) {
+            rewind(fp);
+            lcdparam_set_crc(data, getfile_crc(fp));
+        }
+        fclose(fp);
+    }
+    if (ret < 0) {
+        ALOGE("%s, parse %s failed", __func__, path);
+        return ret;
+    }
+
+    ret = lcdparam_check(data);
+    if (ret < 0) {
+        ALOGE("%s, %s rejected, lcdparam partition not changed", __func__, path);
+    }
+
+    return ret;
+}
+
+/**
+* @decs: /proc/mounts中u盘或sdcard挂载行的crc
+* @param:
+* @return: crc, 0: 没有挂载
+*/
+static uint32 media_mounts_crc(void)
+{
+    char line[256];
+    uint32 crc = 0;
+    FILE *fp;
+
+    fp = fopen("/proc/mounts", "r");
+    if (fp == NULL) {
+        return 0;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        if (strstr(line, " " LCDPARAM_MEDIA_PATH)) {
+            crc = get_crc32(crc, (uint8 *)line, strlen(line));
+        }
+    }
+    fclose(fp);
+
+    return crc;
+}
+
+/**
+* @decs: 用一个find查找u盘或sdcard中的所有文件, 挂载没有变化时
+*        LCDPARAM_MEDIA_RESCAN_US内不再重复查找, 没有挂载时不查找
+* @param: files
+* @return: 0：success <0: failed
+*/
+static int scan_media_files(struct media_files *files)
+{
+    static uint32 last_mounts;
+    static struct timeval last_scan;
+    struct timeval now;
+    char line[256];
+    char *name, *slot;
+    uint32 mounts = media_mounts_crc();
+    FILE *stream;
+
+    gettimeofday(&now, NULL);
+    if (mounts == last_mounts
+        && (mounts == 0 || (now.tv_sec - last_scan.tv_sec) * 1000000LL
+                           + now.tv_usec - last_scan.tv_usec < LCDPARAM_MEDIA_RESCAN_US)) {
+        return 0;
+    }
+    last_mounts = mounts;
+    last_scan = now;
+
+    memset(files, 0, sizeof(*files));
+    if (mounts == 0) {
+        return 0;
+    }
+
+    stream = popen(LCDPARAM_MEDIA_FIND, "r");
+    if (stream == NULL) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), stream)) {
+        strreplace(line, '\n', '\0');
+        name = strrchr(line, '/');
+        name = name ? name + 1 : line;
+
+        if (!strcmp(name, "lcd_parameters")) {
+            slot = files->params;
+        } else if (!strcmp(name, LCDPARAM_CATALOG_NAME)) {
+            slot = files->catalog;
+        } else if (!strcmp(name, LCDPARAM_LOGO_NAME)) {
+            slot = files->logo;
+        } else if (strlen(name) > 5 && !strcmp(name + strlen(name) - 5, ".edid")) {
+            slot = files->edid;
+        } else {
+            continue;
+        }
+        if (!slot[0]) {
+            snprintf(slot, sizeof(files->params), "%s", line);
+        }
+    }
+    pclose(stream);
+
+    return 0;
+}
+
+/**
+* @decs: 取最近一次查找到的文件
+* @param: file, path, len
+* @return: 0：success <0: not found
+*/
+static int media_file(const char *file, char *path, int len)
+{
+    if (!file[0] || access(file, 0)) {
+        return -1;
+    }
+    snprintf(path, len, "%s", file);
+
+    return 0;
+}
+
+/**
+* @decs: u盘或sdcard中有logo.bmp时, 按屏参缩放后写入lcdparam分区的logo槽
+*        槽中已是同一个key时不转换也不写入
+* @param: data
+* @return: 0：success或没有logo <0: failed
+*/
+int update_logo_slot(const uint8 *data)
+{
+    struct lcdparam_logo_header header;
+    char logo[128];
+    uint8 *slot;
+    uint32 len, key;
+    off_t size;
+    int fd;
+    int ret = 0;
+
+    scan_media_files(&media);
+    if (media_file(media.logo, logo, sizeof(logo))) {
+        return 0;
+    }
+
+    if (lcdparam_logo_key(logo, data, &key) < 0) {
+        return -1;
+    }
+
+    fd = open(LCDPARAM_PARTITIOM_NODE_PATH, O_RDWR);
+    if (fd < 0) {
+        ALOGE("%s, open %s failed, err=%d\n", __func__, LCDPARAM_PARTITIOM_NODE_PATH, fd);
+        return -1;
+    }
+
+    if (pread(fd, &header, sizeof(header), LCDPARAM_LOGO_OFFSET) == sizeof(header)
+        && header.magic == LCDPARAM_LOGO_MAGIC && header.key == key) {
+        ALOGE("%s, %s already in logo slot", __func__, logo);
+        close(fd);
+        return 0;
+    }
+
+    slot = lcdparam_logo_build(logo, data, &len);
+    if (slot == NULL) {
+        ALOGE("%s, convert %s failed, boot logo not changed", __func__, logo);
+        close(fd);
+        return -1;
+    }
+
+    size = lseek(fd, 0, SEEK_END);
+    if (size < (off_t)(LCDPARAM_LOGO_OFFSET + len)) {
+        ALOGE("%s, logo needs %lu bytes, lcdparam partition is %ld bytes, increase it",
+              __func__, LCDPARAM_LOGO_OFFSET + len, (long)size);
+        ret = -1;
+    } else if (pwrite(fd, slot, len, LCDPARAM_LOGO_OFFSET) != (ssize_t)len) {
+        ALOGE("%s, write logo slot failed", __func__);
+        ret = -1;
+    } else {
+        ALOGE("%s, %s written to logo slot, %lu bytes", __func__, logo, len);
+    }
+
+    close(fd);
+    free(slot);
+
+    return ret;
+}
+
+/**
+* @decs: 用lcdparam分区中的屏参更新logo槽
+* @param:
+* @return: 0：success或没有logo <0: failed
+*/
+int update_logo_slot_from_nand(void)
+{
+    LCDPARAM_STORGAE_T sysData;
+    int sys_fd;
+    int ret;
+
+    sys_fd = open(LCDPARAM_PARTITIOM_NODE_PATH, O_RDONLY);
+    if (sys_fd < 0) {
+        ALOGE("%s, open %s failed, err=%d\n", __func__, LCDPARAM_PARTITIOM_NODE_PATH, sys_fd);
+        return -1;
+    }
+
+    ret = read(sys_fd, (void*)&sysData, sizeof(sysData));
+    close(sys_fd);
+    if (ret != sizeof(sysData)) {
+        ALOGE("%s, read %s failed, err=%d\n", __func__, LCDPARAM_PARTITIOM_NODE_PATH, ret);
+        return -1;
+    }
+
+    return update_logo_slot(sysData.data);
+}
+
+/**
+* @decs: 每次扫描检查logo.bmp, 文件或屏参变化后才更新logo槽,
+*        不必等新的lcd_parameters
+* @param:
+* @return: 0：success或没有变化 <0: failed
+*/
+int rk_update_logo_from_sdcard(void)
+{
+    static char last_logo[128];
+    static off_t last_size;
+    static time_t last_mtime;
+    static uint32 last_crc;
+    char logo[128];
+    struct stat st;
+
+    scan_media_files(&media);
+    if (media_file(media.logo, logo, sizeof(logo)) || stat(logo, &st)) {
+        last_logo[0] = '\0';
+        return 0;
+    }
+
+    if (!strcmp(logo, last_logo) && st.st_size == last_size && st.st_mtime == last_mtime
+        && nand_crc == last_crc) {
+        return 0;
+    }
+
+    strcpy(last_logo, logo);
+    last_size = st.st_size;
+    last_mtime = st.st_mtime;
+    last_crc = nand_crc;
+
+    return update_logo_slot_from_nand();
+}
+
 /**
 * @decs: 从sdcard中读取屏参保存到oem分区
 * @param:
@@ -439,26 +577,21 @@ int rk_update_lcd_parameters_from_sdcard(void)
 {
     int ret = 0;
     FILE *fp = 0;
-    int n = 0;
-    char line[20480] = {0};
-    int i = 0;
     LCDPARAM_STORGAE_T sysData;
     int sys_fd = 0;
-    int oem_fd = 0;
     static uint32 file_crc = 0; //file lcdparameter  crc data
+    static uint32 rejected_crc = 0; //file lcdparameter crc failed to check
     static int updated = 0; //had store the param into the nand
     static char got_crc = 0; //get file crc flag
     char lcdparameter_buf[128];
-    FILE *stream;
+    char value[16];
+    uint32 blob_crc;
 
-    memset(lcdparameter_buf, '\0', sizeof(lcdparameter_buf));
     memset(sysData.data, '\0', sizeof(sysData.data));
-    stream = popen(LCDPARAM_FILE_PATH, "r");
-    fread(lcdparameter_buf, sizeof(char), sizeof(lcdparameter_buf), stream);
-    strreplace(lcdparameter_buf, '\n', '\0');
-    pclose(stream);
-
-    while (access(lcdparameter_buf, 0)) {
+    scan_media_files(&media);
+    if (media_file(media.params, lcdparameter_buf, sizeof(lcdparameter_buf))
+        && media_file(media.catalog, lcdparameter_buf, sizeof(lcdparameter_buf))
+        && media_file(media.edid, lcdparameter_buf, sizeof(lcdparameter_buf))) {
         if (updated) {
             updated = 0;
         }
@@ -485,89 +618,19 @@ int rk_update_lcd_parameters_from_sdcard(void)
             fclose(fp);
         }
 
-        if ((nand_crc != file_crc)) {
-            fp = fopen(lcdparameter_buf, "r");
-            if (fp == NULL) {
-                ALOGE("%s, open %s failed again", __func__, lcdparameter_buf);
+        if (nand_crc != file_crc && rejected_crc != file_crc) {
+            if (check_lcd_parameters(lcdparameter_buf, sysData.data) < 0) {
+                rejected_crc = file_crc;
                 return -1;
-            } else {
-                ALOGE("%s, open %s success again", __func__, lcdparameter_buf);
             }
 
-            while (fgets(line, 20480, fp)) {
-                char *p = strtrim(line);
-                int len = strlen(p);
-
-                if (len <= 0) {
-                    continue;
-                } else if (p[0] == '#') {
-                    continue;
-                } else if (!strstr(p, "=") && !strstr(p, ";")) {
-                    continue;
-                } else {
-                    // get key and value string like "screen_lvds_format = 1" spilt by ";"
-                    char *key_val_str = strtok(p, ";");
-                    char *value = strchr(key_val_str, '=');
-                    char cmd[4] = {'\0'};
-                    if (value == NULL) {
-                        continue;
-                    }
-                    for (i = 0; i < CONFIG_MAX; i++) {
-                        if (strstr(p, key[i])) {
-                            char *val = strdelchr(value, '=');
-                            strrmspace(val);
-                            uint32 config1 = atoi(val);
-
-                            sync_properties(key[i], val);
-
-                            if (strstr(p, "panel-init-sequence")) {
-                                int count = 0;
-                                int cmdlen = strlen(val) / 2;
-                                uint8 cmdu8;
-
-                                sysData.data[i * 4] = (uint8)(cmdlen >> 24);
-                                sysData.data[i * 4 + 1] = (uint8)(cmdlen >> 16);
-                                sysData.data[i * 4 + 2] = (uint8)(cmdlen >> 8);
-                                sysData.data[i * 4 + 3] = (uint8)(cmdlen >> 0);
-                                ALOGE("%s, %s=%d val %s", __func__, key[i], config1, val);
-                                i ++;
-
-                                while (1) {
-                                    cmd [0] = '0';
-                                    cmd [1] = 'x';
-                                    cmd [2] = *val;
-                                    cmd [3] = *(++val);
-                                    uint8 cmdu8 = strtol(cmd, NULL, 16);
-                                    sysData.data[i * 4 + count++] = cmdu8;
-
-                                    ALOGE("%s, cmd=%d count=%d total=%d", __func__, cmdu8, count, cmdlen);
-                                    if (count < cmdlen) {
-                                        ++val;    //next cmd
-                                    } else {
-                                        break;
-                                    }
-                                }
-
-
-                            } else {
-                                sysData.data[i * 4] = (uint8)(config1 >> 24);
-                                sysData.data[i * 4 + 1] = (uint8)(config1 >> 16);
-                                sysData.data[i * 4 + 2] = (uint8)(config1 >> 8);
-                                sysData.data[i * 4 + 3] = (uint8)(config1 >> 0);
-                                ALOGE("%s, %s=%d val %s", __func__, key[i], config1, val);
-                            }
-                            break;
-                        }
-                    }
-
-                }
-
+            // file crc data, a catalog profile keeps the crc of its own source
+            blob_crc = lcdparam_get_crc(sysData.data);
+            if (blob_crc == nand_crc) {
+                ALOGE("%s, profile already in lcdparam partition", __func__);
+                updated = 1;
+                return 0;
             }
-            // file crc data
-            sysData.data[LCDPARAM_STORGAE_DATA_LEN - 4] = (uint8)(file_crc >> 24);
-            sysData.data[LCDPARAM_STORGAE_DATA_LEN - 3] = (uint8)(file_crc >> 16);
-            sysData.data[LCDPARAM_STORGAE_DATA_LEN - 2] = (uint8)(file_crc >> 8);
-            sysData.data[LCDPARAM_STORGAE_DATA_LEN - 1] = (uint8)(file_crc >> 0);
             ALOGE("%s, crc32 = 0X%02X%02X%02X%02X", __func__, sysData.data[LCDPARAM_STORGAE_DATA_LEN - 4],
                   sysData.data[LCDPARAM_STORGAE_DATA_LEN - 3],
                   sysData.data[LCDPARAM_STORGAE_DATA_LEN - 2],
@@ -583,35 +646,94 @@ int rk_update_lcd_parameters_from_sdcard(void)
                 ret = write(sys_fd, (void*)&sysData.data[0], LCDPARAM_STORGAE_DATA_LEN);
                 if (ret < 0) {
                     ALOGE("%s, write %s failed, err=%d\n", __func__, LCDPARAM_PARTITIOM_NODE_PATH, sys_fd);
+                    close(sys_fd);
                     return -1;
                 }
+                close(sys_fd);
             }
 
-            close(sys_fd);
             if (ret == -1) {
                 ALOGE("%s, save lcdparam failed!!!\n", __func__);
             } else {
+                snprintf(value, sizeof(value), "%lu", lcdparam_get(sysData.data, LCDPARAM_ORIENTATION));
+                sync_properties("orientation", value);
+                snprintf(value, sizeof(value), "%lu", lcdparam_get(sysData.data, LCDPARAM_DENSITY));
+                sync_properties("density", value);
+
+                update_logo_slot(sysData.data);
+
                 updated = 1;
-                nand_crc = file_crc;
-                fclose(fp);
+                nand_crc = blob_crc;
                 sync();
                 reboot(RB_AUTOBOOT);
             }
-            fclose(fp);
             return ret;
         }
     }
     return ret;
 }
 
+static int read_dt_property(const char *path, uint8 *buf, int len)
+{
+    FILE *fp = fopen(path, "rb");
+    int ret;
+
+    if (fp == NULL) {
+        return -1;
+    }
+    ret = fread(buf, 1, len, fp);
+    fclose(fp);
+
+    return ret;
+}
+
+/**
+* @decs: 报告uboot记录的开机显示各阶段耗时, 来自/chosen/rockchip,display-timeline
+* @param: none
+* @return: 0：success <0: no timeline
+*/
+int report_boot_display_timeline(void)
+{
+    uint8 cells[256];
+    char names[256];
+    char value[PROPERTY_VALUE_MAX];
+    const char *name = names;
+    uint32 start, duration, total = 0;
+    int len, names_len, i;
+
+    len = read_dt_property(LCDPARAM_TIMELINE_PATH, cells, sizeof(cells));
+    names_len = read_dt_property(LCDPARAM_TIMELINE_NAMES_PATH, (uint8 *)names, sizeof(names) - 1);
+    if (len < 8 || names_len <= 0) {
+        ALOGE("no boot display timeline from uboot");
+        return -1;
+    }
+    names[names_len] = '\0';
+
+    /* <start duration> pairs, big endian, in us */
+    for (i = 0; i + 8 <= len && name < names + names_len; i += 8) {
+        start = (uint32)cells[i] << 24 | cells[i + 1] << 16 | cells[i + 2] << 8 | cells[i + 3];
+        duration = (uint32)cells[i + 4] << 24 | cells[i + 5] << 16 | cells[i + 6] << 8 | cells[i + 7];
+        ALOGE("boot display %-15s %7lu us, from %lu us", name, duration, start);
+        total += duration;
+        name += strlen(name) + 1;
+    }
+
+    ALOGE("boot display total %lu us", total);
+    snprintf(value, sizeof(value), "%lu", total);
+    property_set(LCDPARAM_TIMELINE_PROPERTY, value);
+
+    return 0;
+}
+
 void help()
 {
-    printf("USAGE: [-srw] [-k key] [-v value]\n");
+    printf("USAGE: [-srw] [-k key] [-v value] [-c file]\n");
     printf("WHERE: -s = scan sdcard and udisk\n");
     printf("       -r = read parameter\n");
     printf("       -w = write parameter\n");
     printf("       -k = key\n");
-    printf("       -v = value\n\n");
+    printf("       -v = value\n");
+    printf("       -c = check lcd_parameters file\n\n");
 }
 
 int main(int argc, char * argv[])
@@ -621,10 +743,12 @@ int main(int argc, char * argv[])
     int opt = OPT_SCAN;
     char key[1024];
     char value[1024];
+    char path[1024];
+    LCDPARAM_STORGAE_T sysData;
 
     ALOGE("%s, go...\n", __func__);
 
-    while ((ch = getopt(argc, argv, "srwk:v:h")) != -1) {
+    while ((ch = getopt(argc, argv, "srwk:v:c:h")) != -1) {
         switch (ch) {
             case 's':
                 opt = OPT_SCAN;
@@ -646,6 +770,11 @@ int main(int argc, char * argv[])
                 strcpy(value, optarg);
                 break;
 
+            case 'c':
+                opt = OPT_CHECK;
+                strcpy(path, optarg);
+                break;
+
             case 'h':
                 help();
                 break;
@@ -659,9 +788,11 @@ int main(int argc, char * argv[])
 
     if (OPT_SCAN == opt) {
         printf("lcdparamservice --> scan\n");
+        report_boot_display_timeline();
         nand_crc = getfile_crc_from_nand();
         while (1) {
             rk_update_lcd_parameters_from_sdcard();
+            rk_update_logo_from_sdcard();
             usleep(100000);
         }
     } else if (OPT_READ == opt) {
@@ -680,8 +811,18 @@ int main(int argc, char * argv[])
             help();
             return -1;
         }
+        if (write_param_to_nand(key, value) < 0) {
+            return -1;
+        }
         sync_properties(key, value);
-        write_param_to_nand(key, value);
+        /* the logo slot is stored rotated and encoded for these two */
+        if (!strcmp(key, "orientation") || !strcmp(key, "logo,format")) {
+            update_logo_slot_from_nand();
+        }
+    } else if (OPT_CHECK == opt) {
+        ret = check_lcd_parameters(path, sysData.data);
+        printf("%s: %s\n", path, ret < 0 ? "rejected" : "ok");
+        return ret;
     }
 
     return 0;
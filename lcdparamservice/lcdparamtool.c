@@ -0,0 +1,240 @@
+/*********************************************************************************
+* Copyright 2019 Bob Shen
+* FileName: lcdparamtool.c
+* Author: Bob Shen
+* Version: 1.0.0
+* Date: 2019-3-14
+* Description:
+*     Host tool, check a lcd_parameters file and compile it into a lcdparam
+*     partition image without flashing the board.
+*
+* Revision:
+*     Date:
+*     Reviser:
+*     Description:
+*********************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <libgen.h>
+
+#include "lcdparam.h"
+
+void help()
+{
+    printf("USAGE: lcdparamtool [-o image [-L logo.bmp]] [-c catalog] lcd_parameters | panel.edid\n");
+    printf("       lcdparamtool -C manifest -o catalog\n");
+    printf("       lcdparamtool -w -k key -v value image\n");
+    printf("WHERE: -o = write lcdparam partition image or catalog\n");
+    printf("       -L = add the boot logo scaled to the panel to the image\n");
+    printf("       -c = catalog of a profile = line, lcd_catalog.bin next to\n");
+    printf("            lcd_parameters by default\n");
+    printf("       -C = build a panel catalog, each manifest line is\n");
+    printf("            name path [board=ID] [serial=FIRST..LAST]\n");
+    printf("       -w = edit one key of an image like lcdparamservice -w\n\n");
+}
+
+/**
+* @decs: 与lcdparamservice -w相同地修改镜像中的一个值
+* @param: image, k, v
+* @return: 0：success <0: failed
+*/
+static int edit_image(const char *image, char *k, char *v)
+{
+    int index = key2Index(k);
+    uint8 data[LCDPARAM_STORGAE_DATA_LEN];
+    FILE *fp;
+
+    if (index < 0 || index >= CONFIG_MAX) {
+        LCDPARAM_LOGE("invalid key %s", k);
+        return -1;
+    }
+
+    fp = fopen(image, "r+b");
+    if (fp == NULL) {
+        LCDPARAM_LOGE("open %s failed", image);
+        return -1;
+    }
+    if (fread(data, 1, sizeof(data), fp) != sizeof(data)) {
+        LCDPARAM_LOGE("read %s failed", image);
+        fclose(fp);
+        return -1;
+    }
+
+    lcdparam_set(data, index, atoi(v));
+    if (lcdparam_check_edit(data, index) < 0) {
+        LCDPARAM_LOGE("%s=%s rejected, %s not changed", k, v, image);
+        fclose(fp);
+        return -1;
+    }
+
+    /* only the 4 bytes of the key, as the service writes them */
+    if (fseek(fp, lcdparam_offset(index), SEEK_SET)
+        || fwrite(data + lcdparam_offset(index), 1, 4, fp) != 4) {
+        LCDPARAM_LOGE("write %s failed", image);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    LCDPARAM_LOGI("%s=%s written to %s", k, v, image);
+
+    return 0;
+}
+
+int main(int argc, char * argv[])
+{
+    int ch;
+    char *image = NULL;
+    char *manifest = NULL;
+    char *logo = NULL;
+    char *catalog = NULL;
+    char catalog_path[1024];
+    struct lcdparam_catalog cat;
+    const uint8 *blob;
+    char *key = NULL;
+    char *value = NULL;
+    int edit = 0;
+    struct lcdparam_options opts;
+    FILE *fp;
+    LCDPARAM_STORGAE_T sysData;
+    uint32 file_crc;
+    uint8 *slot = NULL;
+    uint32 slot_len = 0;
+
+    while ((ch = getopt(argc, argv, "o:C:L:c:wk:v:h")) != -1) {
+        switch (ch) {
+            case 'o':
+                image = optarg;
+                break;
+
+            case 'C':
+                manifest = optarg;
+                break;
+
+            case 'L':
+                logo = optarg;
+                break;
+
+            case 'c':
+                catalog = optarg;
+                break;
+
+            case 'w':
+                edit = 1;
+                break;
+
+            case 'k':
+                key = optarg;
+                break;
+
+            case 'v':
+                value = optarg;
+                break;
+
+            case 'h':
+            default:
+                help();
+                return -1;
+        }
+    }
+
+    if (manifest) {
+        if (!image) {
+            help();
+            return -1;
+        }
+        return lcdparam_catalog_build(manifest, image);
+    }
+
+    if (edit) {
+        if (!key || !value || optind >= argc) {
+            help();
+            return -1;
+        }
+        return edit_image(argv[optind], key, value);
+    }
+
+    if (optind >= argc) {
+        help();
+        return -1;
+    }
+
+    fp = fopen(argv[optind], "r");
+    if (fp == NULL) {
+        LCDPARAM_LOGE("open %s failed", argv[optind]);
+        return -1;
+    }
+
+    file_crc = getfile_crc(fp);
+    rewind(fp);
+
+    if (lcdparam_parse(fp, argv[optind], sysData.data, &opts) < 0) {
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    if (opts.profile[0]) {
+        /* the catalog is next to lcd_parameters, as for lcdparamservice */
+        if (!catalog) {
+            strncpy(catalog_path, argv[optind], sizeof(catalog_path) - 1);
+            catalog_path[sizeof(catalog_path) - 1] = '\0';
+            snprintf(catalog_path, sizeof(catalog_path), "%s/%s", dirname(catalog_path),
+                     LCDPARAM_CATALOG_NAME);
+            catalog = catalog_path;
+        }
+        if (lcdparam_catalog_open(&cat, catalog) < 0) {
+            return -1;
+        }
+        blob = lcdparam_catalog_find(&cat, opts.profile);
+        if (blob == NULL) {
+            LCDPARAM_LOGE("profile %s not found in %s", opts.profile, catalog);
+            lcdparam_catalog_close(&cat);
+            return -1;
+        }
+        /* a catalog profile keeps the crc of its own source */
+        memcpy(sysData.data, blob, LCDPARAM_STORGAE_DATA_LEN);
+        file_crc = lcdparam_get_crc(sysData.data);
+        lcdparam_catalog_close(&cat);
+        LCDPARAM_LOGI("%s selects catalog profile %s of %s", argv[optind], opts.profile, catalog);
+    }
+
+    if (lcdparam_check(sysData.data) < 0) {
+        LCDPARAM_LOGE("%s rejected", argv[optind]);
+        return -1;
+    }
+
+    if (logo) {
+        slot = lcdparam_logo_build(logo, sysData.data, &slot_len);
+        if (slot == NULL) {
+            return -1;
+        }
+    }
+
+    if (image) {
+        lcdparam_set_crc(sysData.data, file_crc);
+
+        fp = fopen(image, "wb");
+        if (fp == NULL) {
+            LCDPARAM_LOGE("open %s failed", image);
+            free(slot);
+            return -1;
+        }
+        if (fwrite(sysData.data, 1, LCDPARAM_STORGAE_DATA_LEN, fp) != LCDPARAM_STORGAE_DATA_LEN
+            || (slot && (fseek(fp, LCDPARAM_LOGO_OFFSET, SEEK_SET)
+                         || fwrite(slot, 1, slot_len, fp) != slot_len))) {
+            LCDPARAM_LOGE("write %s failed", image);
+            fclose(fp);
+            free(slot);
+            return -1;
+        }
+        fclose(fp);
+        LCDPARAM_LOGI("%s written, crc32 = 0X%08lX", image, file_crc);
+    }
+    free(slot);
+
+    return 0;
+}
@@ -0,0 +1,299 @@
+/*
+ * (C) Copyright 2008-2016 Fuzhou Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ */
+
+#ifdef USE_HOSTCC
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+
+#define ENOTSUPP                    524
+#else
+#include <common.h>
+#include <errno.h>
+#endif
+
+#include "rockchip_bmp.h"
+
+/*
+ * Palettized bmp logos, 1/4/8 bpp and RLE4/RLE8, decoded to the rgb565 of
+ * the 16 bpp logo path in a single pass: the palette is converted once into
+ * lookup tables of 1, 2 or 8 ready pixels per source byte, runs are filled
+ * from the table and the bottom up rows land top down. Anything else still
+ * goes through bmpdecoder().
+ *
+ * The source is either the whole file in memory or streamed through the
+ * read callback into a band buffer, so a logo larger than the boot buffer
+ * decodes with one band of memory.
+ */
+#define BMP_HDR_DATA_OFFSET         10
+#define BMP_HDR_INFO_SIZE           14
+#define BMP_HDR_WIDTH               18
+#define BMP_HDR_HEIGHT              22
+#define BMP_HDR_BIT_COUNT           28
+#define BMP_HDR_COMPRESSION         30
+#define BMP_HDR_COLORS_USED         46
+#define BMP_FILE_HDR_LEN            14
+
+#define BMP_BI_RGB                  0
+#define BMP_BI_RLE8                 1
+#define BMP_BI_RLE4                 2
+
+struct bmp_lut {
+    u16 pal[256];               /* one pixel per index */
+    u32 pair[256];              /* 4 bpp, both pixels of a byte */
+    u16 bits[256][8];           /* 1 bpp, all eight pixels of a byte */
+};
+
+static struct bmp_lut bmp_lut;
+
+static u32 bmp_le32(const u8 *p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (u32)p[3] << 24;
+}
+
+static u32 bmp_le16(const u8 *p)
+{
+    return p[0] | p[1] << 8;
+}
+
+/* len bytes of the file at offset, reading the next band when needed */
+static const u8 *bmp_src_get(struct rockchip_bmp_src *src, u32 offset, u32 len)
+{
+    u32 block, blocks, total;
+
+    if (offset + len > src->size || offset + len < offset) {
+        return NULL;
+    }
+    if (src->mem) {
+        return src->mem + offset;
+    }
+
+    if (offset < src->band_pos || offset + len > src->band_pos + src->band_len) {
+        block = offset / ROCKCHIP_BMP_BLK_SIZE;
+        total = (src->size + ROCKCHIP_BMP_BLK_SIZE - 1) / ROCKCHIP_BMP_BLK_SIZE;
+        blocks = ROCKCHIP_BMP_BAND_SIZE / ROCKCHIP_BMP_BLK_SIZE;
+        if (blocks > total - block) {
+            blocks = total - block;
+        }
+        src->band_len = 0;
+        if (src->read(src->priv, block, src->band, blocks)) {
+            return NULL;
+        }
+        src->band_pos = block * ROCKCHIP_BMP_BLK_SIZE;
+        src->band_len = blocks * ROCKCHIP_BMP_BLK_SIZE;
+        if (offset + len > src->band_pos + src->band_len) {
+            return NULL;
+        }
+    }
+
+    return src->band + offset - src->band_pos;
+}
+
+/* pixels of a run of count from x that land in the row */
+static int bmp_rle_span(int x, int count, int width)
+{
+    if (x >= width) {
+        return 0;
+    }
+
+    return count < width - x ? count : width - x;
+}
+
+static int bmp_decode_rle(struct rockchip_bmp_src *src, u32 pos, u16 *dst, int width, int height,
+                          int bpp, bool bottom_up)
+{
+    int x = 0, row = 0, n, i;
+    const u8 *p;
+    u16 *d, pixel;
+    u8 a, b;
+
+    memset(dst, 0, width * height * 2);
+
+    while (row < height && (p = bmp_src_get(src, pos, 2))) {
+        a = p[0];
+        b = p[1];
+        pos += 2;
+        d = dst + (bottom_up ? height - 1 - row : row) * width;
+
+        if (a) {
+            /* run of a pixels, in rle4 alternating the two nibbles */
+            n = bmp_rle_span(x, a, width);
+            if (bpp == 8) {
+                pixel = bmp_lut.pal[b];
+                for (i = 0; i < n; i++) {
+                    d[x + i] = pixel;
+                }
+            } else {
+                for (i = 0; i + 2 <= n; i += 2) {
+                    memcpy(&d[x + i], &bmp_lut.pair[b], sizeof(bmp_lut.pair[0]));
+                }
+                if (i < n) {
+                    d[x + i] = bmp_lut.pal[b >> 4];
+                }
+            }
+            x += a;
+        } else if (b == 0) {
+            x = 0;
+            row++;
+        } else if (b == 1) {
+            break;
+        } else if (b == 2) {
+            p = bmp_src_get(src, pos, 2);
+            if (!p) {
+                return -EINVAL;
+            }
+            x += p[0];
+            row += p[1];
+            pos += 2;
+        } else {
+            /* absolute run of b pixels, padded to 16 bits */
+            p = bmp_src_get(src, pos, bpp == 8 ? b : (b + 1) / 2);
+            if (!p) {
+                return -EINVAL;
+            }
+            n = bmp_rle_span(x, b, width);
+            if (bpp == 8) {
+                for (i = 0; i < n; i++) {
+                    d[x + i] = bmp_lut.pal[p[i]];
+                }
+            } else {
+                for (i = 0; i + 2 <= n; i += 2) {
+                    memcpy(&d[x + i], &bmp_lut.pair[p[i / 2]], sizeof(bmp_lut.pair[0]));
+                }
+                if (i < n) {
+                    d[x + i] = bmp_lut.pal[p[i / 2] >> 4];
+                }
+            }
+            pos += ((bpp == 8 ? b : (b + 1) / 2) + 1) & ~1;
+            x += b;
+        }
+    }
+
+    return 0;
+}
+
+static int bmp_decode_rows(struct rockchip_bmp_src *src, u32 pos, u16 *dst, int width, int height,
+                           int bpp, bool bottom_up)
+{
+    int stride = ((width * bpp + 31) / 32) * 4;
+    int row, x;
+
+    if (!src->mem && stride + ROCKCHIP_BMP_BLK_SIZE > ROCKCHIP_BMP_BAND_SIZE) {
+        return -ENOTSUPP;
+    }
+
+    for (row = 0; row < height; row++) {
+        const u8 *s = bmp_src_get(src, pos + row * stride, stride);
+        u16 *d = dst + (bottom_up ? height - 1 - row : row) * width;
+
+        if (!s) {
+            return -EINVAL;
+        }
+
+        if (bpp == 8) {
+            for (x = 0; x + 4 <= width; x += 4) {
+                d[x] = bmp_lut.pal[s[x]];
+                d[x + 1] = bmp_lut.pal[s[x + 1]];
+                d[x + 2] = bmp_lut.pal[s[x + 2]];
+                d[x + 3] = bmp_lut.pal[s[x + 3]];
+            }
+            for (; x < width; x++) {
+                d[x] = bmp_lut.pal[s[x]];
+            }
+        } else if (bpp == 4) {
+            for (x = 0; x + 2 <= width; x += 2) {
+                memcpy(&d[x], &bmp_lut.pair[s[x / 2]], sizeof(bmp_lut.pair[0]));
+            }
+            if (x < width) {
+                d[x] = bmp_lut.pal[s[x / 2] >> 4];
+            }
+        } else {
+            for (x = 0; x + 8 <= width; x += 8) {
+                memcpy(&d[x], bmp_lut.bits[s[x / 8]], sizeof(bmp_lut.bits[0]));
+            }
+            if (x < width) {
+                memcpy(&d[x], bmp_lut.bits[s[x / 8]], (width - x) * sizeof(u16));
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* 0 when decoded, <0 when bmpdecoder() has to do it */
+int rockchip_bmp_decode(struct rockchip_bmp_src *src, u16 *dst)
+{
+    u32 data_offset, info_size, compression, colors, i, j;
+    int width, height, bpp;
+    bool bottom_up = true;
+    const u8 *hdr, *palette;
+
+    hdr = bmp_src_get(src, 0, BMP_HDR_COLORS_USED + 4);
+    if (!hdr) {
+        return -EINVAL;
+    }
+
+    data_offset = bmp_le32(hdr + BMP_HDR_DATA_OFFSET);
+    info_size = bmp_le32(hdr + BMP_HDR_INFO_SIZE);
+    width = bmp_le32(hdr + BMP_HDR_WIDTH);
+    height = bmp_le32(hdr + BMP_HDR_HEIGHT);
+    bpp = bmp_le16(hdr + BMP_HDR_BIT_COUNT);
+    compression = bmp_le32(hdr + BMP_HDR_COMPRESSION);
+    colors = bmp_le32(hdr + BMP_HDR_COLORS_USED);
+
+    if (bpp != 1 && bpp != 4 && bpp != 8) {
+        return -ENOTSUPP;
+    }
+    if (!(compression == BMP_BI_RGB || (compression == BMP_BI_RLE8 && bpp == 8)
+          || (compression == BMP_BI_RLE4 && bpp == 4))) {
+        return -ENOTSUPP;
+    }
+    if (height < 0) {
+        height = -height;
+        bottom_up = false;
+    }
+    if (width <= 0 || height == 0 || data_offset >= src->size) {
+        return -EINVAL;
+    }
+
+    if (!colors || colors > (1u << bpp)) {
+        colors = 1 << bpp;
+    }
+    palette = bmp_src_get(src, BMP_FILE_HDR_LEN + info_size, colors * 4);
+    if (!palette) {
+        return -EINVAL;
+    }
+
+    /* b, g, r, x entries to rgb565, missing entries black */
+    memset(&bmp_lut, 0, sizeof(bmp_lut));
+    for (i = 0; i < colors; i++) {
+        const u8 *c = palette + i * 4;
+
+        bmp_lut.pal[i] = (c[2] >> 3) << 11 | (c[1] >> 2) << 5 | c[0] >> 3;
+    }
+    if (bpp == 4) {
+        for (i = 0; i < 256; i++) {
+            bmp_lut.pair[i] = bmp_lut.pal[i >> 4] | (u32)bmp_lut.pal[i & 0xf] << 16;
+        }
+    } else if (bpp == 1) {
+        for (i = 0; i < 256; i++) {
+            for (j = 0; j < 8; j++) {
+                bmp_lut.bits[i][j] = bmp_lut.pal[(i >> (7 - j)) & 1];
+            }
+        }
+    }
+
+    if (compression == BMP_BI_RGB) {
+        return bmp_decode_rows(src, data_offset, dst, width, height, bpp, bottom_up);
+    }
+
+    return bmp_decode_rle(src, data_offset, dst, width, height, bpp, bottom_up);
+}
@@ -0,0 +1,31 @@
+/*
+ * (C) Copyright 2008-2016 Fuzhou Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _ROCKCHIP_BMP_H
+#define _ROCKCHIP_BMP_H
+
+/*
+ * Palettized bmp decoder of the logo path, see rockchip_bmp.c. Plain C,
+ * also built on the host with USE_HOSTCC for lcdparambench.
+ */
+#define ROCKCHIP_BMP_BLK_SIZE		512
+#define ROCKCHIP_BMP_BAND_SIZE		(64 * 1024)
+
+struct rockchip_bmp_src {
+	const u8 *mem;		/* whole file, NULL when streaming */
+	u32 size;
+
+	/* streaming: blocks of ROCKCHIP_BMP_BLK_SIZE into a band */
+	int (*read)(void *priv, u32 block, void *buf, u32 blocks);
+	void *priv;
+	u8 *band;		/* ROCKCHIP_BMP_BAND_SIZE bytes */
+	u32 band_pos;		/* file offset of band[0] */
+	u32 band_len;
+};
+
+int rockchip_bmp_decode(struct rockchip_bmp_src *src, u16 *dst);
+
+#endif
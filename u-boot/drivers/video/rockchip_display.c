@@ -10,6 +10,7 @@
 #include <config.h>
 #include <common.h>
 #include <errno.h>
+#include <stdarg.h>
 #include <fdtdec.h>
 #include <fdt_support.h>
 #include <linux/list.h>
@@ -24,6 +25,8 @@
 #include "rockchip_connector.h"
 #include "rockchip_phy.h"
 #include "rockchip_panel.h"
+#include "rockchip_phandle.h"
+#include "rockchip_bmp.h"
 
 #define DRIVER_VERSION  "develop-v1.0.0"
 
@@ -46,6 +49,67 @@ static unsigned long memory_end;
 extern int rk_pwm_bl_config(int brightness);
 #endif
 
+/*
+ * Every character on the uart costs about 87us at 115200 baud. The detail
+ * of the display path goes to a ram ring only, which the kernel gets as
+ * the rockchip,display-log reserved memory. Errors are still printed.
+ * display_loglevel=1 in the environment prints the info lines as well,
+ * display_loglevel=2 everything.
+ */
+#define DISPLAY_LOG_ERR             0
+#define DISPLAY_LOG_INFO            1
+#define DISPLAY_LOG_DEBUG           2
+
+#ifndef CONFIG_ROCKCHIP_DISPLAY_LOGLEVEL
+#define CONFIG_ROCKCHIP_DISPLAY_LOGLEVEL    DISPLAY_LOG_ERR
+#endif
+
+#define DISPLAY_LOG_SIZE            (16 * 1024)
+#define DISPLAY_LOG_MAGIC           0x474f4c44    /* "DLOG" */
+
+#define DISPLAY_INFO(fmt, args...)  display_log(DISPLAY_LOG_INFO, fmt, ##args)
+#define DISPLAY_DBG(fmt, args...)   display_log(DISPLAY_LOG_DEBUG, fmt, ##args)
+
+/* head counts all bytes ever written, data[head % sizeof(data)] is next */
+static struct {
+    u32 magic;
+    u32 size;
+    u32 head;
+    char data[DISPLAY_LOG_SIZE - 3 * sizeof(u32)];
+} display_log_ring __aligned(4096);
+
+static int display_loglevel = -1;
+
+static void display_log(int level, const char *fmt, ...)
+{
+    char line[256];
+    va_list args;
+    const char *env;
+    int len, i;
+
+    if (display_loglevel < 0) {
+        env = getenv("display_loglevel");
+        display_loglevel = env ? simple_strtoul(env, NULL, 10) : CONFIG_ROCKCHIP_DISPLAY_LOGLEVEL;
+    }
+
+    va_start(args, fmt);
+    len = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (len > (int)sizeof(line) - 1) {
+        len = sizeof(line) - 1;
+    }
+
+    if (level <= display_loglevel) {
+        puts(line);
+    }
+
+    display_log_ring.magic = DISPLAY_LOG_MAGIC;
+    display_log_ring.size = sizeof(display_log_ring.data);
+    for (i = 0; i < len; i++) {
+        display_log_ring.data[display_log_ring.head++ % sizeof(display_log_ring.data)] = line[i];
+    }
+}
+
 /*
  * the phy types are used by different connectors in public.
  * The current version only has inno hdmi phy for hdmi and tve.
@@ -129,7 +193,7 @@ static int get_public_phy(struct display_state *state,
             }
             conn_state->phy = phy;
 
-            printf("inno hdmi phy init success, save it\n");
+            DISPLAY_INFO("inno hdmi phy init success, save it\n");
             data->phy_node = conn_state->phy_node;
             data->private_date = conn_state->phy_private;
             data->phy_drv = conn_state->phy;
@@ -172,6 +236,87 @@ static bool can_direct_logo(int bpp)
     return bpp == 24 || bpp == 32;
 }
 
+/*
+ * Where the boot to first pixel time goes. Every stage keeps its first start
+ * and the time summed over all its runs, in us since the timer started. The
+ * table goes to /chosen/rockchip,display-timeline of the kernel dt as
+ * <start duration> pairs, named by rockchip,display-timeline-names.
+ */
+enum display_stage {
+    DISPLAY_STAGE_LCDPARAM_READ,
+    DISPLAY_STAGE_DT_FIXUP,
+    DISPLAY_STAGE_PHY_INIT,
+    DISPLAY_STAGE_INIT,
+    DISPLAY_STAGE_LOGO_LOAD,
+    DISPLAY_STAGE_ENABLE,
+    DISPLAY_STAGE_PANEL_ENABLE,
+    DISPLAY_STAGE_KERNEL_FIXUP,
+    DISPLAY_STAGE_COUNT
+};
+
+static const char * const display_stage_names[DISPLAY_STAGE_COUNT] = {
+    "lcdparam-read",
+    "dt-fixup",
+    "phy-init",
+    "display-init",
+    "logo-load",
+    "display-enable",
+    "panel-enable",
+    "kernel-fixup",
+};
+
+static struct {
+    u32 start;
+    u32 total;
+} display_timeline[DISPLAY_STAGE_COUNT];
+
+static void display_stage_end(enum display_stage stage, unsigned long start)
+{
+    if (!display_timeline[stage].start) {
+        display_timeline[stage].start = start;
+    }
+    display_timeline[stage].total += timer_get_us() - start;
+}
+
+/*
+ * The display graph walks resolve every route, endpoint and native-mode
+ * phandle through one rockchip_phandle index of the blob instead of
+ * fdt_node_offset_by_phandle(). Any write that can move node offsets
+ * drops it, the next lookup builds it again on the edited blob.
+ */
+static struct rockchip_phandle_index phandle_index;
+
+static int display_phandle_index_build(const void *blob)
+{
+    unsigned long start = timer_get_us();
+    int ret;
+
+    ret = rockchip_phandle_index_build(&phandle_index, blob);
+    if (ret) {
+        return ret;
+    }
+
+    DISPLAY_DBG("display phandle index: %d nodes, %lu us\n", phandle_index.count,
+                timer_get_us() - start);
+
+    return 0;
+}
+
+/* a property that grew or shrank, or a new node, moved the nodes behind it */
+static void display_phandle_index_drop(void)
+{
+    phandle_index.blob = NULL;
+}
+
+static int display_node_offset_by_phandle(const void *blob, u32 phandle)
+{
+    if (phandle_index.blob != blob && display_phandle_index_build(blob)) {
+        return fdt_node_offset_by_phandle(blob, phandle);
+    }
+
+    return rockchip_phandle_index_lookup(&phandle_index, phandle);
+}
+
 static int get_panel_node(const void *blob, int conn_node)
 {
     int panel, ports, port, ep, remote, ph, nodedepth;
@@ -194,7 +339,7 @@ static int get_panel_node(const void *blob, int conn_node)
                 continue;
             }
 
-            remote = fdt_node_offset_by_phandle(blob, ph);
+            remote = display_node_offset_by_phandle(blob, ph);
 
             nodedepth = fdt_node_depth(blob, remote);
             if (nodedepth < 2) {
@@ -251,7 +396,7 @@ static int connector_phy_init(struct display_state *state,
         return 0;
     }
 
-    phy_node = fdt_node_offset_by_phandle(blob, phandle);
+    phy_node = display_node_offset_by_phandle(blob, phandle);
     if (phy_node < 0) {
         printf("failed to find phy node\n");
         return phy_node;
@@ -306,6 +451,12 @@ static int connector_panel_init(struct display_state *state)
 
     panel_state->panel = panel;
 
+    /* waited by display_panel_step(), the panel driver leaves them alone */
+    panel_state->prepare_delay_ms = fdtdec_get_int(blob, panel_node, "prepare-delay-ms", 0);
+    panel_state->reset_delay_ms = fdtdec_get_int(blob, panel_node, "reset-delay-ms", 0);
+    panel_state->enable_delay_ms = fdtdec_get_int(blob, panel_node, "enable-delay-ms", 0);
+    panel_state->step = PANEL_STEP_POWER;
+
     ret = rockchip_panel_init(state);
     if (ret) {
         printf("failed to init panel driver\n");
@@ -381,7 +532,7 @@ static int display_get_timing_from_dts(int panel, const void *blob,
     if (native_mode < 0) {
         phandle = fdt_getprop_u32_default_node(blob, timing, 0,
                                                "native-mode", -1);
-        native_mode = fdt_node_offset_by_phandle_node(blob, timing, phandle);
+        native_mode = display_node_offset_by_phandle(blob, phandle);
         if (native_mode <= 0) {
             printf("failed to get display timings from DT\n");
             return -ENXIO;
@@ -564,6 +715,16 @@ bool drm_mode_is_420(const struct drm_display_info *display,
            drm_mode_is_420_also(display, mode);
 }
 
+static int display_get_timing_from_lcdparam(struct display_state *state,
+                                            struct drm_display_mode *mode);
+static int display_get_timing_from_edid_cache(struct display_state *state,
+                                              struct drm_display_mode *mode);
+static void display_edid_cache_store(struct display_state *state,
+                                     const struct drm_display_mode *mode);
+static void display_edid_cache_revalidate(struct display_state *state);
+
+static void display_panel_power_up(struct display_state *state);
+
 static int display_get_timing(struct display_state *state)
 {
     const struct rockchip_connector *conn = state->conn_state.connector;
@@ -581,19 +742,29 @@ static int display_get_timing(struct display_state *state)
         return -ENODEV;
     }
 
+    if (!display_get_timing_from_lcdparam(state, mode)) {
+        DISPLAY_INFO("Using display timing from lcdparam\n");
+        goto done;
+    }
+
     if (!display_get_timing_from_dts(panel, blob, mode)) {
-        printf("Using display timing dts\n");
+        DISPLAY_INFO("Using display timing dts\n");
         goto done;
     }
 
     m = rockchip_get_display_mode_from_panel(state);
     if (m) {
-        printf("Using display timing from compatible panel driver\n");
+        DISPLAY_INFO("Using display timing from compatible panel driver\n");
         memcpy(mode, m, sizeof(*m));
         goto done;
     }
 
-    rockchip_panel_prepare(state);
+    if (conn_funcs->get_edid && !display_get_timing_from_edid_cache(state, mode)) {
+        DISPLAY_INFO("Using display timing from cached edid\n");
+        goto done;
+    }
+
+    display_panel_power_up(state);
 
     if (conn_funcs->get_edid && !conn_funcs->get_edid(state)) {
         int panel_bits_per_colourp;
@@ -601,8 +772,9 @@ static int display_get_timing(struct display_state *state)
         if (!edid_get_drm_mode((void *)&conn_state->edid,
                                sizeof(conn_state->edid), mode,
                                &panel_bits_per_colourp)) {
-            printf("Using display timing from edid\n");
+            DISPLAY_INFO("Using display timing from edid\n");
             edid_print_info((void *)&conn_state->edid);
+            display_edid_cache_store(state, mode);
             goto done;
         }
     }
@@ -610,16 +782,16 @@ static int display_get_timing(struct display_state *state)
     printf("failed to find display timing\n");
     return -ENODEV;
 done:
-    printf("Detailed mode clock %u kHz, flags[%x]\n"
-           "    H: %04d %04d %04d %04d\n"
-           "    V: %04d %04d %04d %04d\n"
-           "bus_format: %x\n",
-           mode->clock, mode->flags,
-           mode->hdisplay, mode->hsync_start,
-           mode->hsync_end, mode->htotal,
-           mode->vdisplay, mode->vsync_start,
-           mode->vsync_end, mode->vtotal,
-           conn_state->bus_format);
+    DISPLAY_DBG("Detailed mode clock %u kHz, flags[%x]\n"
+                "    H: %04d %04d %04d %04d\n"
+                "    V: %04d %04d %04d %04d\n"
+                "bus_format: %x\n",
+                mode->clock, mode->flags,
+                mode->hdisplay, mode->hsync_start,
+                mode->hsync_end, mode->htotal,
+                mode->vdisplay, mode->vsync_start,
+                mode->vsync_end, mode->vtotal,
+                conn_state->bus_format);
 
     return 0;
 }
@@ -632,11 +804,13 @@ static int display_init(struct display_state *state)
     const struct rockchip_crtc_funcs *crtc_funcs = crtc->funcs;
     const struct connector_state *conn_state = &state->conn_state;
     struct drm_display_mode *mode = &conn_state->mode;
+    unsigned long start;
     int ret = 0;
 
     if (state->is_init) {
         return 0;
     }
+    start = timer_get_us();
 
     if (!conn_funcs || !crtc_funcs) {
         printf("failed to find connector or crtc functions\n");
@@ -698,6 +872,7 @@ static int display_init(struct display_state *state)
     }
 
     state->is_init = 1;
+    display_stage_end(DISPLAY_STAGE_INIT, start);
 
     return 0;
 
@@ -730,12 +905,133 @@ static int display_set_plane(struct display_state *state)
     return 0;
 }
 
+static int display_start_video(struct display_state *state)
+{
+    const struct rockchip_connector *conn = state->conn_state.connector;
+    const struct rockchip_crtc *crtc = state->crtc_state.crtc;
+    const struct rockchip_connector_funcs *conn_funcs = conn->funcs;
+    const struct rockchip_crtc_funcs *crtc_funcs = crtc->funcs;
+    int ret;
+
+    if (crtc_funcs->enable) {
+        ret = crtc_funcs->enable(state);
+        if (ret) {
+            goto unprepare_conn;
+        }
+    }
+
+    if (conn_funcs->enable) {
+        ret = conn_funcs->enable(state);
+        if (ret) {
+            goto disable_crtc;
+        }
+    }
+
+    return 0;
+unprepare_conn:
+    if (conn_funcs->unprepare) {
+        conn_funcs->unprepare(state);
+    }
+disable_crtc:
+    if (crtc_funcs->disable) {
+        crtc_funcs->disable(state);
+    }
+    return ret;
+}
+
+/*
+ * Wait for the deadline of the next power up step of the panel, run it and
+ * set the deadline of the step after it from the delay the panel node asks
+ * for. Nothing else waits these delays, so displays whose steps interleave
+ * wait them out together.
+ */
+static void display_panel_step(struct display_state *state)
+{
+    struct panel_state *panel_state = &state->panel_state;
+    long remain = (long)(panel_state->step_at - timer_get_us());
+    unsigned long start = timer_get_us();
+    int delay_ms = 0;
+
+    if (remain > 0) {
+        udelay(remain);
+    }
+
+    switch (panel_state->step) {
+        case PANEL_STEP_POWER:
+            rockchip_panel_prepare(state);
+            delay_ms = panel_state->prepare_delay_ms;
+            break;
+        case PANEL_STEP_RESET:
+            rockchip_panel_prepare(state);
+            delay_ms = panel_state->reset_delay_ms;
+            break;
+        case PANEL_STEP_INIT:
+            rockchip_panel_prepare(state);
+            break;
+        case PANEL_STEP_VIDEO:
+            if (display_start_video(state)) {
+                printf("failed to start the video\n");
+                panel_state->pending = false;
+                return;
+            }
+            delay_ms = panel_state->enable_delay_ms;
+            break;
+        case PANEL_STEP_ENABLE:
+            rockchip_panel_enable(state);
+            state->is_enable = true;
+            break;
+        default:
+            break;
+    }
+
+    display_stage_end(panel_state->step == PANEL_STEP_ENABLE ? DISPLAY_STAGE_PANEL_ENABLE
+                      : DISPLAY_STAGE_ENABLE, start);
+    if (panel_state->step < PANEL_STEP_DONE) {
+        panel_state->step++;
+    }
+    panel_state->step_at = timer_get_us() + delay_ms * 1000;
+    panel_state->pending = panel_state->step < PANEL_STEP_DONE;
+}
+
+/* the edid read needs the panel powered up, right away */
+static void display_panel_power_up(struct display_state *state)
+{
+    while (state->panel_state.step < PANEL_STEP_VIDEO) {
+        display_panel_step(state);
+    }
+    state->panel_state.pending = false;
+}
+
+/* set by rockchip_show_logo() to collect the panel power ups of all displays */
+static bool display_enable_deferred;
+
+/* run the pending panel steps in deadline order, the delays overlap */
+static void display_enable_pending_panels(void)
+{
+    struct display_state *s, *next;
+
+    do {
+        next = NULL;
+        list_for_each_entry(s, &rockchip_display_list, head) {
+            if (s->panel_state.pending
+                && (!next || (long)(s->panel_state.step_at - next->panel_state.step_at) < 0)) {
+                next = s;
+            }
+        }
+        if (next) {
+            display_panel_step(next);
+        }
+    } while (next);
+}
+
 static int display_enable(struct display_state *state)
 {
     const struct rockchip_connector *conn = state->conn_state.connector;
     const struct rockchip_crtc *crtc = state->crtc_state.crtc;
     const struct rockchip_connector_funcs *conn_funcs = conn->funcs;
     const struct rockchip_crtc_funcs *crtc_funcs = crtc->funcs;
+    struct panel_state *panel_state = &state->panel_state;
+    unsigned long start;
     int ret = 0;
 
     display_init(state);
@@ -744,9 +1040,10 @@ static int display_enable(struct display_state *state)
         return -EINVAL;
     }
 
-    if (state->is_enable) {
+    if (state->is_enable || panel_state->pending) {
         return 0;
     }
+    start = timer_get_us();
 
     if (crtc_funcs->prepare) {
         ret = crtc_funcs->prepare(state);
@@ -761,37 +1058,30 @@ static int display_enable(struct display_state *state)
             goto unprepare_crtc;
         }
     }
+    display_stage_end(DISPLAY_STAGE_ENABLE, start);
 
-    rockchip_panel_prepare(state);
-
-    if (crtc_funcs->enable) {
-        ret = crtc_funcs->enable(state);
-        if (ret) {
-            goto unprepare_conn;
+    /* a panel powered up for its edid goes on with the video */
+    panel_state->step_at = timer_get_us();
+    panel_state->pending = true;
+    if (display_enable_deferred) {
+        /* the power step right away, its delay overlaps the next display */
+        if (panel_state->step == PANEL_STEP_POWER) {
+            display_panel_step(state);
         }
-    }
-
-    if (conn_funcs->enable) {
-        ret = conn_funcs->enable(state);
-        if (ret) {
-            goto disable_crtc;
+    } else {
+        while (panel_state->pending) {
+            display_panel_step(state);
         }
     }
 
-    rockchip_panel_enable(state);
-
-    state->is_enable = true;
-
     return 0;
 unprepare_crtc:
     if (crtc_funcs->unprepare) {
         crtc_funcs->unprepare(state);
     }
-unprepare_conn:
     if (conn_funcs->unprepare) {
         conn_funcs->unprepare(state);
     }
-disable_crtc:
     if (crtc_funcs->disable) {
         crtc_funcs->disable(state);
     }
@@ -824,6 +1114,7 @@ static int display_disable(struct display_state *state)
     }
 
     rockchip_panel_unprepare(state);
+    state->panel_state.step = PANEL_STEP_POWER;
 
     if (conn_funcs->unprepare) {
         conn_funcs->unprepare(state);
@@ -912,7 +1203,7 @@ static int get_crtc_id(const void *blob, int connect)
     if (phandle < 0) {
         goto err;
     }
-    remote = fdt_node_offset_by_phandle(blob, phandle);
+    remote = display_node_offset_by_phandle(blob, phandle);
 
     val = fdtdec_get_int(blob, remote, "reg", -1);
     if (val < 0) {
@@ -944,7 +1235,7 @@ static int find_connector_node(const void *blob, int node)
 
     phandle = fdt_getprop_u32_default_node(blob, node, 0,
                                            "remote-endpoint", -1);
-    remote = fdt_node_offset_by_phandle(blob, phandle);
+    remote = display_node_offset_by_phandle(blob, phandle);
     nodedepth = fdt_node_depth(blob, remote);
 
     return fdt_supernode_atdepth_offset(blob, remote,
@@ -977,6 +1268,42 @@ struct rockchip_logo_cache *find_or_alloc_logo_cache(const char *bmp)
     return logo_cache;
 }
 
+static int bmp_read_content(void *priv, u32 block, void *buf, u32 blocks)
+{
+    return load_content_data(priv, block, buf, blocks);
+}
+
+/*
+ * Palettized logos through rockchip_bmp_decode(), straight from the
+ * resource partition with one band in memory.
+ */
+static int bmp_decode_stream(const char *bmp_name, u32 size, u16 *dst)
+{
+    struct rockchip_bmp_src src;
+    resource_content content;
+    int ret;
+
+    memset(&content, 0, sizeof(content));
+    snprintf(content.path, sizeof(content.path), "%s", bmp_name);
+    if (!get_content(0, &content)) {
+        return -ENOENT;
+    }
+
+    memset(&src, 0, sizeof(src));
+    src.size = size;
+    src.read = bmp_read_content;
+    src.priv = &content;
+    src.band = malloc(ROCKCHIP_BMP_BAND_SIZE);
+    if (!src.band) {
+        return -ENOMEM;
+    }
+
+    ret = rockchip_bmp_decode(&src, dst);
+    free(src.band);
+
+    return ret;
+}
+
 static int load_bmp_logo(struct logo_info *logo, const char *bmp_name)
 {
     struct rockchip_logo_cache *logo_cache;
@@ -1007,24 +1334,9 @@ static int load_bmp_logo(struct logo_info *logo, const char *bmp_name)
     logo->height = get_unaligned_le32(&header->height);
     size = get_unaligned_le32(&header->file_size);
     if (!can_direct_logo(logo->bpp)) {
-        if (size > CONFIG_RK_BOOT_BUFFER_SIZE) {
-            printf("failed to use boot buf as temp bmp buffer\n");
-            return -ENOMEM;
-        }
-        pdst = (void *)gd->arch.rk_boot_buf_addr;
-
-    } else {
-        pdst = get_display_buffer(size);
-        dst = pdst;
-    }
-
-    if (load_bmp_content(bmp_name, pdst, size)) {
-        printf("failed to load bmp %s\n", bmp_name);
-        return 0;
-    }
-
-    if (!can_direct_logo(logo->bpp)) {
+        struct rockchip_bmp_src src;
         int dst_size;
+
         /*
          * TODO: force use 16bpp if bpp less than 16;
          */
@@ -1035,13 +1347,40 @@ static int load_bmp_logo(struct logo_info *logo, const char *bmp_name)
         if (!dst) {
             return -ENOMEM;
         }
-        if (bmpdecoder(pdst, dst, logo->bpp)) {
-            printf("failed to decode bmp %s\n", bmp_name);
-            return 0;
-        }
         logo->offset = 0;
         logo->ymirror = 0;
+
+        /* palettized logos need neither the boot buffer nor a full read */
+        if (logo->bpp == 16 && !bmp_decode_stream(bmp_name, size, dst)) {
+            DISPLAY_DBG("bmp %s decoded in bands\n", bmp_name);
+        } else {
+            if (size > CONFIG_RK_BOOT_BUFFER_SIZE) {
+                printf("failed to use boot buf as temp bmp buffer\n");
+                return -ENOMEM;
+            }
+            pdst = (void *)gd->arch.rk_boot_buf_addr;
+            if (load_bmp_content(bmp_name, pdst, size)) {
+                printf("failed to load bmp %s\n", bmp_name);
+                return 0;
+            }
+
+            memset(&src, 0, sizeof(src));
+            src.mem = pdst;
+            src.size = size;
+            if (logo->bpp == 16 && !rockchip_bmp_decode(&src, dst)) {
+                DISPLAY_DBG("bmp %s decoded with palette tables\n", bmp_name);
+            } else if (bmpdecoder(pdst, dst, logo->bpp)) {
+                printf("failed to decode bmp %s\n", bmp_name);
+                return 0;
+            }
+        }
     } else {
+        pdst = get_display_buffer(size);
+        dst = pdst;
+        if (load_bmp_content(bmp_name, pdst, size)) {
+            printf("failed to load bmp %s\n", bmp_name);
+            return 0;
+        }
         logo->offset = get_unaligned_le32(&header->data_offset);
         logo->ymirror = 1;
     }
@@ -1071,18 +1410,59 @@ void rockchip_show_bmp(const char *bmp)
     }
 }
 
+static int load_lcdparam_logo(struct display_state *state);
+
 void rockchip_show_logo(void)
 {
     struct display_state *s;
+    unsigned long start;
+    int ret;
 
+    /*
+     * Bring up every display with its u-boot logo first, the remaining
+     * panel power up steps of all displays run right after, so their
+     * delays overlap.
+     */
+    display_enable_deferred = true;
     list_for_each_entry(s, &rockchip_display_list, head) {
         s->logo.mode = s->logo_mode;
-        if (load_bmp_logo(&s->logo, s->ulogo_name)) {
+        /* keep the display init out of the logo load time */
+        display_init(s);
+
+        start = timer_get_us();
+        ret = load_lcdparam_logo(s);
+        display_stage_end(DISPLAY_STAGE_LOGO_LOAD, start);
+        s->lcdparam_logo = !ret;
+        if (!ret) {
+            display_logo(s);
+            continue;
+        }
+
+        start = timer_get_us();
+        ret = load_bmp_logo(&s->logo, s->ulogo_name);
+        display_stage_end(DISPLAY_STAGE_LOGO_LOAD, start);
+        if (ret) {
             printf("failed to display uboot logo\n");
         } else {
             display_logo(s);
         }
-        if (load_bmp_logo(&s->logo, s->klogo_name)) {
+    }
+    display_enable_deferred = false;
+    display_enable_pending_panels();
+
+    /* nothing below is on screen before the kernel takes over */
+    list_for_each_entry(s, &rockchip_display_list, head) {
+        display_edid_cache_revalidate(s);
+
+        /* the kernel keeps showing the same pre-scaled logo */
+        if (s->lcdparam_logo) {
+            continue;
+        }
+
+        start = timer_get_us();
+        ret = load_bmp_logo(&s->logo, s->klogo_name);
+        display_stage_end(DISPLAY_STAGE_LOGO_LOAD, start);
+        if (ret) {
             printf("failed to display kernel logo\n");
         }
     }
@@ -1135,6 +1515,11 @@ struct display_fixup_data {
 
     int init_sequence_len;
     u8 *init_sequence_buf;
+
+    /* for edp panel, 0 keeps the dts and link training default */
+    int edp_link_rate;
+    int edp_lanes;
+    int edp_bpc;
 };
 
 enum {
@@ -1163,15 +1548,82 @@ char *lvds_channel[] = {
 #if 1
 extern const disk_partition_t* get_disk_partition(const char *name);
 extern int StorageReadLba(uint32 LBA, void *pbuf, uint32 nSec);
+extern int StorageWriteLba(uint32 LBA, void *pbuf, uint32 nSec, uint16 mode);
 
 #define LCDPARAM_PARTITION_NAME     "lcdparam"
 #define LCDPARAM_STORGAE_DATA_LEN   2048
 #define LCDPARAM_MAX_COUNT          34
+#define LCDPARAM_EXT_OFFSET         1536
+#define LCDPARAM_EXT_COUNT          3
+
+/* boot logo prepared by lcdparamservice at the panel resolution */
+#define LCDPARAM_LOGO_OFFSET        0x100000
+#define LCDPARAM_LOGO_MAGIC         0x4f474c4c
+#define LCDPARAM_LOGO_VERSION       1
+#define LCDPARAM_LOGO_CACHE_NAME    "lcdparam-logo"
+
+/*
+ * edid and mode of the routes that take their timing from an edid, one
+ * slot per route. The display comes up with the cached mode without any
+ * ddc traffic, the edid is read again once the logo is shown.
+ */
+#define LCDPARAM_MODE_CACHE_OFFSET      0x82000
+#define LCDPARAM_MODE_CACHE_SLOTS       8
+#define LCDPARAM_MODE_CACHE_SLOT_SIZE   1024
+#define LCDPARAM_MODE_CACHE_MAGIC       0x434d4445    /* "EDMC" */
+#define LCDPARAM_MODE_CACHE_VERSION     1
+
+struct lcdparam_mode_cache {
+    u32 magic;
+    u32 version;
+    char route[32];
+    u32 edid_crc;
+    u32 clock;
+    u32 hdisplay, hsync_start, hsync_end, htotal;
+    u32 vdisplay, vsync_start, vsync_end, vtotal;
+    u32 flags;
+    u8 edid[EDID_SIZE * 4];
+};
+
+struct lcdparam_logo_header {
+    u32 magic;
+    u32 version;
+    u32 format;
+    u32 width;
+    u32 height;
+    u32 stride;
+    u32 size;
+    u32 data_offset;
+    u32 rotation;
+    u32 key;
+};
+
+/* D-PHY lane rate range in Mbps */
+#define DSI_LANE_RATE_MIN           80
+#define DSI_LANE_RATE_MAX           1000
+
+/* eDP link rate in Mbps per lane and its DPCD link bandwidth code */
+#define EDP_LINK_RATE_RBR           1620
+#define EDP_LINK_RATE_HBR           2700
+#define DP_LINK_BW_1_62             0x06
+#define DP_LINK_BW_2_7              0x0a
 
 int lcd_param[LCDPARAM_MAX_COUNT];
+int lcd_param_ext[LCDPARAM_EXT_COUNT];
 char param_buf_temp[LCDPARAM_STORGAE_DATA_LEN] = {0};
 
-int get_lcdparam_info_from_custom_partition(struct display_fixup_data *data)
+/*
+ * The partition is read and decoded once per boot, rockchip_display_init()
+ * and the kernel dt fixup share the result. init_sequence_buf points into
+ * param_buf_temp, which is never read again.
+ */
+static struct display_fixup_data lcdparam_fixup_data;
+static int lcdparam_read_ret = 1;
+/* read time of the prefetch and when it ended, 0 when the display read it */
+static unsigned long lcdparam_prefetch_us;
+static unsigned long lcdparam_prefetch_end;
+
+static int read_lcdparam_info_from_custom_partition(struct display_fixup_data *data)
 {
     int i;
     const disk_partition_t *ptn1 = get_disk_partition(LCDPARAM_PARTITION_NAME);
@@ -1181,7 +1633,7 @@ int get_lcdparam_info_from_custom_partition(struct display_fixup_data *data)
         return -1;
     }
 
-    printf("block num: %lu, name %s ,type %s,block size :%lu\n", ptn1->size, ptn1->name, ptn1->type, ptn1->blksz);
+    DISPLAY_DBG("block num: %lu, name %s ,type %s,block size :%lu\n", ptn1->size, ptn1->name, ptn1->type, ptn1->blksz);
 
     if (StorageReadLba(ptn1->start, param_buf_temp, DIV_ROUND_UP(sizeof(param_buf_temp), RK_BLK_SIZE)) != 0) {
         printf("failed to read lcdparam!\n");
@@ -1193,12 +1645,19 @@ int get_lcdparam_info_from_custom_partition(struct display_fixup_data *data)
         lcd_param[i] = (lcd_param[i] << 8) + param_buf_temp[i * 4 + 1];
         lcd_param[i] = (lcd_param[i] << 8) + param_buf_temp[i * 4 + 2];
         lcd_param[i] = (lcd_param[i] << 8) + param_buf_temp[i * 4 + 3];
-        printf("--get-- lcd_param %d\n", lcd_param[i]);
+        DISPLAY_DBG("--get-- lcd_param %d\n", lcd_param[i]);
     }
 
-    printf("-get- crc32 = 0X%02X%02X%02X%02X\n",
-           param_buf_temp[LCDPARAM_STORGAE_DATA_LEN - 4], param_buf_temp[LCDPARAM_STORGAE_DATA_LEN - 3],
-           param_buf_temp[LCDPARAM_STORGAE_DATA_LEN - 2], param_buf_temp[LCDPARAM_STORGAE_DATA_LEN - 1]);
+    /* keys added later, zero in blobs written before them */
+    for (i = 0; i < LCDPARAM_EXT_COUNT; i++) {
+        u8 *p = (u8 *)&param_buf_temp[LCDPARAM_EXT_OFFSET + i * 4];
+
+        lcd_param_ext[i] = (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+    }
+
+    DISPLAY_DBG("-get- crc32 = 0X%02X%02X%02X%02X\n",
+                param_buf_temp[LCDPARAM_STORGAE_DATA_LEN - 4], param_buf_temp[LCDPARAM_STORGAE_DATA_LEN - 3],
+                param_buf_temp[LCDPARAM_STORGAE_DATA_LEN - 2], param_buf_temp[LCDPARAM_STORGAE_DATA_LEN - 1]);
     if (param_buf_temp[LCDPARAM_STORGAE_DATA_LEN - 4] == 0
         && param_buf_temp[LCDPARAM_STORGAE_DATA_LEN - 3] == 0
         && param_buf_temp[LCDPARAM_STORGAE_DATA_LEN - 2] == 0
@@ -1252,182 +1711,657 @@ int get_lcdparam_info_from_custom_partition(struct display_fixup_data *data)
     // for mipi init sequence, in the end
     data->init_sequence_len = lcd_param[33];
     data->init_sequence_buf = (u8 *)&param_buf_temp[LCDPARAM_MAX_COUNT * 4];
+
+    // for edp panel
+    data->edp_link_rate = lcd_param_ext[0];
+    data->edp_lanes = lcd_param_ext[1];
+    data->edp_bpc = lcd_param_ext[2];
     return 0;
 }
 
-#endif
+/*
+ * StorageReadLba() has no asynchronous request, so the prefetch is the
+ * same blocking read done as soon as the storage is up. It only moves the
+ * read off the display path when the board calls it before display init,
+ * get_lcdparam_info_from_custom_partition() logs how early that was.
+ */
+void rockchip_display_prefetch_lcdparam(void)
+{
+    unsigned long start;
 
-static int fdt_fixup_node_status(void *blob, int node, enum fdt_status status)
+    if (lcdparam_read_ret <= 0) {
+        return;
+    }
+
+    start = timer_get_us();
+    lcdparam_read_ret = read_lcdparam_info_from_custom_partition(&lcdparam_fixup_data);
+    display_stage_end(DISPLAY_STAGE_LCDPARAM_READ, start);
+    lcdparam_prefetch_end = timer_get_us();
+    lcdparam_prefetch_us = lcdparam_prefetch_end - start;
+    if (!lcdparam_prefetch_us) {
+        lcdparam_prefetch_us = 1;
+    }
+}
+
+int get_lcdparam_info_from_custom_partition(struct display_fixup_data *data)
 {
-    int ret;
+    unsigned long start;
 
-    printf("fixup %s %d\n", fdt_get_name(blob, node, NULL), status);
+    if (lcdparam_read_ret > 0) {
+        start = timer_get_us();
+        lcdparam_read_ret = read_lcdparam_info_from_custom_partition(&lcdparam_fixup_data);
+        display_stage_end(DISPLAY_STAGE_LCDPARAM_READ, start);
+    } else if (lcdparam_prefetch_us) {
+        DISPLAY_INFO("lcdparam prefetch read %lu us, done %lu us before display init\n",
+                     lcdparam_prefetch_us, timer_get_us() - lcdparam_prefetch_end);
+        lcdparam_prefetch_us = 0;
+    }
+    if (lcdparam_read_ret) {
+        return lcdparam_read_ret;
+    }
 
-set_status:
-    ret = fdt_set_node_status(blob, node, status, 0);
-    if (ret == -FDT_ERR_NOSPACE) {
-        ret = fdt_increase_size(blob, 512);
-        if (!ret) {
-            goto set_status;
+    memcpy(data, &lcdparam_fixup_data, sizeof(*data));
+    return 0;
+}
+
+static const char *lcdparam_route_name(int type)
+{
+    switch (type) {
+        case PANEL_TYPE_DSI:
+            return "route-dsi0";
+        case PANEL_TYPE_EDP:
+            return "route-edp";
+        case PANEL_TYPE_LVDS:
+            return "route-lvds";
+        default:
+            return NULL;
+    }
+}
+
+/*
+ * The timing the route fixup writes to the dt is already decoded, take it
+ * from there instead of reading the same properties back from the blob.
+ * Only for the route lcdparam selects, the others keep the dt timing.
+ */
+static int display_get_timing_from_lcdparam(struct display_state *state,
+                                            struct drm_display_mode *mode)
+{
+    struct display_fixup_data data;
+    const char *route;
+
+    if (get_lcdparam_info_from_custom_partition(&data)) {
+        return -ENODEV;
+    }
+
+    route = lcdparam_route_name(data.type);
+    if (!route || strcmp(fdt_get_name(state->blob, state->node, NULL), route)) {
+        return -ENODEV;
+    }
+
+    if (data.hactive <= 0 || data.vactive <= 0 || data.clock_frequency <= 0) {
+        return -EINVAL;
+    }
+
+    mode->hdisplay = data.hactive;
+    mode->hsync_start = mode->hdisplay + data.hfront_porch;
+    mode->hsync_end = mode->hsync_start + data.hsync_len;
+    mode->htotal = mode->hsync_end + data.hback_porch;
+
+    mode->vdisplay = data.vactive;
+    mode->vsync_start = mode->vdisplay + data.vfront_porch;
+    mode->vsync_end = mode->vsync_start + data.vsync_len;
+    mode->vtotal = mode->vsync_end + data.vback_porch;
+
+    mode->clock = data.clock_frequency / 1000;
+    mode->flags = (data.hsync_active ? DRM_MODE_FLAG_PHSYNC : DRM_MODE_FLAG_NHSYNC)
+                  | (data.vsync_active ? DRM_MODE_FLAG_PVSYNC : DRM_MODE_FLAG_NVSYNC);
+
+    if (data.type == PANEL_TYPE_LVDS
+        && data.lvds_bus_format < sizeof(lvds_bus_format) / sizeof(lvds_bus_format[0])) {
+        state->conn_state.bus_format = lvds_bus_format[data.lvds_bus_format];
+    }
+
+    return 0;
+}
+
+static u8 mode_cache_buf[LCDPARAM_MODE_CACHE_SLOTS * LCDPARAM_MODE_CACHE_SLOT_SIZE]
+    __aligned(ARCH_DMA_MINALIGN);
+static int mode_cache_read_ret = 1;
+
+static struct lcdparam_mode_cache *display_edid_cache_slot(struct display_state *state, bool alloc)
+{
+    const char *route = fdt_get_name(state->blob, state->node, NULL);
+    struct lcdparam_mode_cache *cache, *unused = NULL;
+    const disk_partition_t *ptn;
+    int i;
+
+    if (mode_cache_read_ret > 0) {
+        ptn = get_disk_partition(LCDPARAM_PARTITION_NAME);
+        if (!ptn || DIV_ROUND_UP(LCDPARAM_MODE_CACHE_OFFSET + sizeof(mode_cache_buf), RK_BLK_SIZE) > ptn->size) {
+            mode_cache_read_ret = -ENODEV;
         } else {
-            goto err_size;
+            mode_cache_read_ret = StorageReadLba(ptn->start + LCDPARAM_MODE_CACHE_OFFSET / RK_BLK_SIZE,
+                                                 mode_cache_buf, sizeof(mode_cache_buf) / RK_BLK_SIZE);
         }
-    } else if (ret < 0) {
-        printf("Can't set node status: %s\n", fdt_strerror(ret));
-        return ret;
+    }
+    if (mode_cache_read_ret || !route) {
+        return NULL;
     }
 
+    for (i = 0; i < LCDPARAM_MODE_CACHE_SLOTS; i++) {
+        cache = (void *)&mode_cache_buf[i * LCDPARAM_MODE_CACHE_SLOT_SIZE];
+        if (cache->magic != LCDPARAM_MODE_CACHE_MAGIC || cache->version != LCDPARAM_MODE_CACHE_VERSION) {
+            if (!unused) {
+                unused = cache;
+            }
+            continue;
+        }
+        if (!strncmp(cache->route, route, sizeof(cache->route))) {
+            return cache;
+        }
+    }
+
+    if (!alloc) {
+        return NULL;
+    }
+    if (!unused) {
+        unused = (void *)mode_cache_buf;
+    }
+    memset(unused, 0, LCDPARAM_MODE_CACHE_SLOT_SIZE);
+    strncpy(unused->route, route, sizeof(unused->route) - 1);
+
+    return unused;
+}
+
+static int display_get_timing_from_edid_cache(struct display_state *state,
+                                              struct drm_display_mode *mode)
+{
+    struct lcdparam_mode_cache *cache = display_edid_cache_slot(state, false);
+
+    if (!cache || !cache->hdisplay || !cache->vdisplay || !cache->clock) {
+        return -ENOENT;
+    }
+
+    memcpy(state->conn_state.edid, cache->edid, sizeof(state->conn_state.edid));
+    mode->clock = cache->clock;
+    mode->hdisplay = cache->hdisplay;
+    mode->hsync_start = cache->hsync_start;
+    mode->hsync_end = cache->hsync_end;
+    mode->htotal = cache->htotal;
+    mode->vdisplay = cache->vdisplay;
+    mode->vsync_start = cache->vsync_start;
+    mode->vsync_end = cache->vsync_end;
+    mode->vtotal = cache->vtotal;
+    mode->flags = cache->flags;
+    state->edid_cached = true;
+
     return 0;
+}
 
-err_size:
-    printf("Can't increase blob size: %s\n", fdt_strerror(ret));
-    return ret;
+static void display_edid_cache_store(struct display_state *state,
+                                     const struct drm_display_mode *mode)
+{
+    struct lcdparam_mode_cache *cache = display_edid_cache_slot(state, true);
+    const disk_partition_t *ptn = get_disk_partition(LCDPARAM_PARTITION_NAME);
+    u32 slot;
+
+    if (!cache || !ptn) {
+        return;
+    }
+
+    cache->magic = LCDPARAM_MODE_CACHE_MAGIC;
+    cache->version = LCDPARAM_MODE_CACHE_VERSION;
+    memcpy(cache->edid, state->conn_state.edid, sizeof(cache->edid));
+    cache->edid_crc = crc32(0, cache->edid, sizeof(cache->edid));
+    cache->clock = mode->clock;
+    cache->hdisplay = mode->hdisplay;
+    cache->hsync_start = mode->hsync_start;
+    cache->hsync_end = mode->hsync_end;
+    cache->htotal = mode->htotal;
+    cache->vdisplay = mode->vdisplay;
+    cache->vsync_start = mode->vsync_start;
+    cache->vsync_end = mode->vsync_end;
+    cache->vtotal = mode->vtotal;
+    cache->flags = mode->flags;
+
+    slot = ((u8 *)cache - mode_cache_buf) / LCDPARAM_MODE_CACHE_SLOT_SIZE;
+    if (StorageWriteLba(ptn->start + (LCDPARAM_MODE_CACHE_OFFSET + slot * LCDPARAM_MODE_CACHE_SLOT_SIZE)
+                        / RK_BLK_SIZE, cache, LCDPARAM_MODE_CACHE_SLOT_SIZE / RK_BLK_SIZE, 0) != 0) {
+        printf("failed to write edid mode cache\n");
+    }
 }
 
-static int fdt_fixup_panel_init_sequence(void *fdt, int node, u8 *buf, int len)
+/*
+ * Read the edid again once the logo is up, off the first pixel path. A new
+ * monitor only updates the cache, the kernel reads its own edid anyway.
+ */
+static void display_edid_cache_revalidate(struct display_state *state)
 {
-    //u8 buf[] = {0x05, 0x78, 0x05, 0x01, 0x02, 0x03, 0x04, 0x05, 0x05, 0x14, 0x02, 0x29, 0x11};
-    int ret;
+    const struct rockchip_connector_funcs *conn_funcs = state->conn_state.connector->funcs;
+    struct lcdparam_mode_cache *cache;
+    struct drm_display_mode mode;
+    int bpc;
+
+    if (!state->edid_cached) {
+        return;
+    }
+    state->edid_cached = false;
+
+    if (conn_funcs->get_edid(state)) {
+        return;
+    }
+
+    cache = display_edid_cache_slot(state, false);
+    if (cache && cache->edid_crc == crc32(0, state->conn_state.edid, sizeof(state->conn_state.edid))) {
+        return;
+    }
 
-    printf("fdt_fixup_panel_init_sequence len =  %d\n", len);
+    memset(&mode, 0, sizeof(mode));
+    if (!edid_get_drm_mode((void *)&state->conn_state.edid, sizeof(state->conn_state.edid),
+                           &mode, &bpc)) {
+        printf("edid changed since the last boot, mode cache updated\n");
+        display_edid_cache_store(state, &mode);
+    }
+}
+
+/*
+ * The logo slot is already at the panel resolution and in a scanout format,
+ * read it straight into the display buffer, no bmp decoding or scaling.
+ */
+static int load_lcdparam_logo(struct display_state *state)
+{
+    const struct drm_display_mode *mode = &state->conn_state.mode;
+    struct logo_info *logo = &state->logo;
+    struct rockchip_logo_cache *logo_cache;
+    struct lcdparam_logo_header *header;
+    const disk_partition_t *ptn;
+    u32 hdr_buf[RK_BLK_SIZE / 4];
+    u32 lba, size;
+    void *dst;
+    int bpp;
+
+    logo_cache = find_or_alloc_logo_cache(LCDPARAM_LOGO_CACHE_NAME);
+    if (!logo_cache) {
+        return -ENOMEM;
+    }
 
-    if (fdt == NULL) {
+    if (logo_cache->logo.mem) {
+        memcpy(logo, &logo_cache->logo, sizeof(*logo));
         return 0;
     }
 
-add_seq:
-    ret = fdt_setprop(fdt, node, "panel-init-sequence", buf, len);
-    if (ret == -FDT_ERR_NOSPACE) {
+    display_init(state);
+    if (!state->is_init) {
+        return -ENODEV;
+    }
 
-        ret = fdt_increase_size(fdt, 512);
-        if (!ret) {
-            goto add_seq;
-        } else {
-            goto err_size;
-        }
-    } else if (ret < 0) {
-        printf("Can't add property: %s\n", fdt_strerror(ret));
-        return ret;
+    ptn = get_disk_partition(LCDPARAM_PARTITION_NAME);
+    if (!ptn) {
+        return -ENODEV;
+    }
+
+    lba = ptn->start + LCDPARAM_LOGO_OFFSET / RK_BLK_SIZE;
+    if (StorageReadLba(lba, hdr_buf, 1) != 0) {
+        return -EIO;
+    }
+
+    header = (struct lcdparam_logo_header *)hdr_buf;
+    if (header->magic != LCDPARAM_LOGO_MAGIC || header->version != LCDPARAM_LOGO_VERSION) {
+        return -ENOENT;
     }
 
+    if (header->width != mode->hdisplay || header->height != mode->vdisplay) {
+        printf("lcdparam logo %ux%u does not match panel %dx%d\n",
+               header->width, header->height, mode->hdisplay, mode->vdisplay);
+        return -EINVAL;
+    }
+
+    switch (header->format) {
+        case ROCKCHIP_FMT_RGB888:
+            bpp = 24;
+            size = header->stride * header->height;
+            break;
+        case ROCKCHIP_FMT_RGB565:
+            /* dithered for 18 bit panels, same pixel layout as a 16 bpp bmp */
+            bpp = 16;
+            size = header->stride * header->height;
+            break;
+        default:
+            printf("lcdparam logo format %u not supported\n", header->format);
+            return -EINVAL;
+    }
+
+    if (header->stride != ALIGN(header->width * bpp, 32) >> 3
+        || header->size != size
+        || header->data_offset % RK_BLK_SIZE
+        || DIV_ROUND_UP(LCDPARAM_LOGO_OFFSET + header->data_offset + header->size,
+                        RK_BLK_SIZE) > ptn->size) {
+        printf("invalid lcdparam logo\n");
+        return -EINVAL;
+    }
+
+    dst = get_display_buffer(ALIGN(header->size, RK_BLK_SIZE));
+    if (!dst) {
+        return -ENOMEM;
+    }
+
+    if (StorageReadLba(lba + header->data_offset / RK_BLK_SIZE, dst,
+                       DIV_ROUND_UP(header->size, RK_BLK_SIZE)) != 0) {
+        printf("failed to read lcdparam logo\n");
+        return -EIO;
+    }
+
+    DISPLAY_INFO("lcdparam logo %ux%u format %u\n", header->width, header->height, header->format);
+
+    logo->mem = dst;
+    logo->offset = 0;
+    logo->ymirror = 0;
+    logo->width = header->width;
+    logo->height = header->height;
+    logo->bpp = bpp;
+
+    memcpy(&logo_cache->logo, logo, sizeof(*logo));
+
     return 0;
+}
 
-err_size:
-    printf("Can't increase blob size: %s\n", fdt_strerror(ret));
-    return ret;
+#endif
+
+/*
+ * Display fixups are queued in a transaction and written in one go: the
+ * blob grows once by the space all new or longer properties need, same
+ * size properties are overwritten in place and unchanged ones are skipped.
+ * Node offsets are looked up on the blob before any write, the commit
+ * writes the nodes from the end of the blob backwards so a growing
+ * property never moves a node that is still to be written.
+ */
+#define FDT_FIXUP_TXN_MAX           64
+
+enum {
+    FDT_FIXUP_SET,
+    FDT_FIXUP_INPLACE,
+    FDT_FIXUP_SKIP,
+};
+
+struct fdt_fixup_prop {
+    int node;
+    const char *name;
+    const void *val;            // NULL for a u32 held in cell
+    int len;
+    fdt32_t cell;
+    int action;
+};
+
+struct fdt_fixup_txn {
+    void *blob;
+    int count;
+    struct fdt_fixup_prop props[FDT_FIXUP_TXN_MAX];
+};
+
+static void fdt_fixup_txn_init(struct fdt_fixup_txn *txn, void *blob)
+{
+    txn->blob = blob;
+    txn->count = 0;
 }
 
+/*
+ * One entry per property, a later fixup of the same property replaces the
+ * queued value so the commit classifies only the value that is written.
+ */
+static struct fdt_fixup_prop *fdt_fixup_queue(struct fdt_fixup_txn *txn, int node,
+                                              const char *name)
+{
+    struct fdt_fixup_prop *prop;
+    int i;
 
-static int fdt_fixup_setprop_u32(void *fdt, int node, const char *name, u32 data)
+    for (i = 0; i < txn->count; i++) {
+        prop = &txn->props[i];
+        if (prop->node == node && !strcmp(prop->name, name)) {
+            return prop;
+        }
+    }
+
+    if (txn->count >= FDT_FIXUP_TXN_MAX) {
+        printf("Can't queue property %s: too many fixups\n", name);
+        return NULL;
+    }
+
+    prop = &txn->props[txn->count++];
+    prop->node = node;
+    prop->name = name;
+
+    return prop;
+}
+
+static int fdt_fixup_setprop(struct fdt_fixup_txn *txn, int node, const char *name,
+                             const void *val, int len)
 {
-    int ret;
+    struct fdt_fixup_prop *prop = fdt_fixup_queue(txn, node, name);
 
-set_prop:
-    ret = fdt_setprop_u32(fdt, node, name, data);
-    if (ret == -FDT_ERR_NOSPACE) {
-        ret = fdt_increase_size(fdt, 512);
-        if (!ret) {
-            goto set_prop;
+    if (!prop) {
+        return -ENOSPC;
+    }
+    prop->val = val;
+    prop->len = len;
+
+    return 0;
+}
+
+static const void *fdt_fixup_prop_val(const struct fdt_fixup_prop *prop)
+{
+    return prop->val ? prop->val : &prop->cell;
+}
+
+static int fdt_fixup_txn_commit(struct fdt_fixup_txn *txn)
+{
+    void *blob = txn->blob;
+    struct fdt_fixup_prop tmp;
+    int extra = 0, space, skipped = 0, inplace = 0;
+    int i, j, len, ret = 0, err;
+    const void *old;
+
+    for (i = 0; i < txn->count; i++) {
+        struct fdt_fixup_prop *prop = &txn->props[i];
+
+        old = fdt_getprop(blob, prop->node, prop->name, &len);
+        if (old && len == prop->len && !memcmp(old, fdt_fixup_prop_val(prop), len)) {
+            prop->action = FDT_FIXUP_SKIP;
+            skipped++;
+        } else if (old && len == prop->len) {
+            prop->action = FDT_FIXUP_INPLACE;
+            inplace++;
+        } else if (old) {
+            prop->action = FDT_FIXUP_SET;
+            if (ALIGN(prop->len, 4) > ALIGN(len, 4)) {
+                extra += ALIGN(prop->len, 4) - ALIGN(len, 4);
+            }
         } else {
-            goto err_size;
+            /* the name may already be in the string table, count it anyway */
+            prop->action = FDT_FIXUP_SET;
+            extra += sizeof(struct fdt_property) + ALIGN(prop->len, 4) + strlen(prop->name) + 1;
         }
-    } else if (ret < 0) {
-        printf("Can't add property: %s\n", fdt_strerror(ret));
-        return ret;
     }
 
-    return 0;
+    space = fdt_totalsize(blob) - fdt_off_dt_strings(blob) - fdt_size_dt_strings(blob);
+    if (space < 0) {
+        space = 0;
+    }
+    if (extra > space) {
+        err = fdt_increase_size(blob, extra - space);
+        if (err) {
+            printf("Can't increase blob size: %s\n", fdt_strerror(err));
+            return err;
+        }
+    }
+
+    /* by node only, fdt_fixup_queue() left one entry per property */
+    for (i = 1; i < txn->count; i++) {
+        tmp = txn->props[i];
+        for (j = i; j > 0 && txn->props[j - 1].node < tmp.node; j--) {
+            txn->props[j] = txn->props[j - 1];
+        }
+        txn->props[j] = tmp;
+    }
+
+    for (i = 0; i < txn->count; i++) {
+        const struct fdt_fixup_prop *prop = &txn->props[i];
+
+        if (prop->action == FDT_FIXUP_SKIP) {
+            continue;
+        }
+        err = -FDT_ERR_NOSPACE;
+        if (prop->action == FDT_FIXUP_INPLACE) {
+            err = fdt_setprop_inplace(blob, prop->node, prop->name, fdt_fixup_prop_val(prop), prop->len);
+        }
+        if (err) {
+            err = fdt_setprop(blob, prop->node, prop->name, fdt_fixup_prop_val(prop), prop->len);
+            display_phandle_index_drop();
+        }
+        if (err < 0) {
+            printf("Can't add property %s: %s\n", prop->name, fdt_strerror(err));
+            ret = err;
+        }
+    }
+
+    DISPLAY_DBG("fdt fixup: %d properties, %d unchanged, %d in place, %d bytes added\n",
+                txn->count, skipped, inplace, extra);
+    txn->count = 0;
 
-err_size:
-    printf("Can't increase blob size: %s\n", fdt_strerror(ret));
     return ret;
 }
 
-static int fdt_fixup_setprop_string(void *fdt, int node, const char *name, char *data)
+static int fdt_fixup_node_status(struct fdt_fixup_txn *txn, int node, enum fdt_status status)
 {
-    int ret;
+    const char *value;
 
-set_prop:
-    ret = fdt_setprop_string(fdt, node, name, data);
-    if (ret == -FDT_ERR_NOSPACE) {
-        ret = fdt_increase_size(fdt, 512);
-        if (!ret) {
-            goto set_prop;
-        } else {
-            goto err_size;
-        }
-    } else if (ret < 0) {
-        printf("Can't add property: %s\n", fdt_strerror(ret));
-        return ret;
+    DISPLAY_DBG("fixup %s %d\n", fdt_get_name(txn->blob, node, NULL), status);
+
+    if (status == FDT_STATUS_OKAY) {
+        value = "okay";
+    } else if (status == FDT_STATUS_DISABLED) {
+        value = "disabled";
+    } else {
+        value = "fail";
     }
 
+    return fdt_fixup_setprop(txn, node, "status", value, strlen(value) + 1);
+}
+
+static int fdt_fixup_panel_init_sequence(struct fdt_fixup_txn *txn, int node, u8 *buf, int len)
+{
+    DISPLAY_DBG("fdt_fixup_panel_init_sequence len =  %d\n", len);
+
+    return fdt_fixup_setprop(txn, node, "panel-init-sequence", buf, len);
+}
+
+static int fdt_fixup_setprop_u32(struct fdt_fixup_txn *txn, int node, const char *name, u32 data)
+{
+    struct fdt_fixup_prop *prop = fdt_fixup_queue(txn, node, name);
+
+    if (!prop) {
+        return -ENOSPC;
+    }
+    prop->val = NULL;
+    prop->len = sizeof(fdt32_t);
+    prop->cell = cpu_to_fdt32(data);
+
     return 0;
+}
 
-err_size:
-    printf("Can't increase blob size: %s\n", fdt_strerror(ret));
-    return ret;
+static int fdt_fixup_setprop_string(struct fdt_fixup_txn *txn, int node, const char *name, char *data)
+{
+    return fdt_fixup_setprop(txn, node, name, data, strlen(data) + 1);
 }
 
 
-static void fdt_fixup_display_timing(void *blob, int node,
+static void fdt_fixup_display_timing(struct fdt_fixup_txn *txn, int node,
                                      const struct display_fixup_data *data)
 {
-    fdt_fixup_setprop_u32(blob, node, "clock-frequency", data->clock_frequency);
-    fdt_fixup_setprop_u32(blob, node, "hactive", data->hactive);
-    fdt_fixup_setprop_u32(blob, node, "hfront-porch", data->hfront_porch);
-    fdt_fixup_setprop_u32(blob, node, "hsync-len", data->hsync_len);
-    fdt_fixup_setprop_u32(blob, node, "hback-porch", data->hback_porch);
-    fdt_fixup_setprop_u32(blob, node, "vactive", data->vactive);
-    fdt_fixup_setprop_u32(blob, node, "vfront-porch", data->vfront_porch);
-    fdt_fixup_setprop_u32(blob, node, "vsync-len", data->vsync_len);
-    fdt_fixup_setprop_u32(blob, node, "vback-porch", data->vback_porch);
-    fdt_fixup_setprop_u32(blob, node, "hsync-active", data->hsync_active);
-    fdt_fixup_setprop_u32(blob, node, "vsync-active", data->vsync_active);
-    fdt_fixup_setprop_u32(blob, node, "de-active", data->de_active);
-    fdt_fixup_setprop_u32(blob, node, "pixelclk-active", data->pixelclk_active);
-}
-
-static void fdt_fixup_panel_node(void *blob, int node, const char *name,
+    fdt_fixup_setprop_u32(txn, node, "clock-frequency", data->clock_frequency);
+    fdt_fixup_setprop_u32(txn, node, "hactive", data->hactive);
+    fdt_fixup_setprop_u32(txn, node, "hfront-porch", data->hfront_porch);
+    fdt_fixup_setprop_u32(txn, node, "hsync-len", data->hsync_len);
+    fdt_fixup_setprop_u32(txn, node, "hback-porch", data->hback_porch);
+    fdt_fixup_setprop_u32(txn, node, "vactive", data->vactive);
+    fdt_fixup_setprop_u32(txn, node, "vfront-porch", data->vfront_porch);
+    fdt_fixup_setprop_u32(txn, node, "vsync-len", data->vsync_len);
+    fdt_fixup_setprop_u32(txn, node, "vback-porch", data->vback_porch);
+    fdt_fixup_setprop_u32(txn, node, "hsync-active", data->hsync_active);
+    fdt_fixup_setprop_u32(txn, node, "vsync-active", data->vsync_active);
+    fdt_fixup_setprop_u32(txn, node, "de-active", data->de_active);
+    fdt_fixup_setprop_u32(txn, node, "pixelclk-active", data->pixelclk_active);
+}
+
+static void fdt_fixup_panel_node(struct fdt_fixup_txn *txn, int node, const char *name,
                                  const struct display_fixup_data *data)
 {
 
     if (!strcmp(name, "dsi0")) {
 
-        fdt_fixup_setprop_u32(blob, node, "dsi,flags", data->flags);
-        fdt_fixup_setprop_u32(blob, node, "dsi,format", data->format);
-        fdt_fixup_setprop_u32(blob, node, "dsi,lanes", data->lanes);
-        fdt_fixup_panel_init_sequence(blob, node, data->init_sequence_buf, data->init_sequence_len);
+        fdt_fixup_setprop_u32(txn, node, "dsi,flags", data->flags);
+        fdt_fixup_setprop_u32(txn, node, "dsi,format", data->format);
+        fdt_fixup_setprop_u32(txn, node, "dsi,lanes", data->lanes);
+        fdt_fixup_panel_init_sequence(txn, node, data->init_sequence_buf, data->init_sequence_len);
 
     } else if (!strcmp(name, "lvds")) {
         if (data->lvds_bus_format < sizeof(lvds_bus_format) / sizeof(lvds_bus_format[0])) {
-            printf("fdt_fixup_panel_node set lvds bus format: 0x%04x\n", lvds_bus_format[data->lvds_bus_format]);
-            fdt_fixup_setprop_u32(blob, node, "bus-format", lvds_bus_format[data->lvds_bus_format]);
+            DISPLAY_DBG("fdt_fixup_panel_node set lvds bus format: 0x%04x\n", lvds_bus_format[data->lvds_bus_format]);
+            fdt_fixup_setprop_u32(txn, node, "bus-format", lvds_bus_format[data->lvds_bus_format]);
         }
         if (data->lvds_mode < sizeof(lvds_mode) / sizeof(lvds_mode[0])) {
-            printf("fdt_fixup_panel_node set lvds mode: %s\n", lvds_mode[data->lvds_mode]);
-            fdt_fixup_setprop_string(blob, node, "rockchip,data-mapping", lvds_mode[data->lvds_mode]);
+            DISPLAY_DBG("fdt_fixup_panel_node set lvds mode: %s\n", lvds_mode[data->lvds_mode]);
+            fdt_fixup_setprop_string(txn, node, "rockchip,data-mapping", lvds_mode[data->lvds_mode]);
         }
-        fdt_fixup_setprop_u32(blob, node, "rockchip,data-width", data->lvds_width);
+        fdt_fixup_setprop_u32(txn, node, "rockchip,data-width", data->lvds_width);
         if (data->lvds_channel < sizeof(lvds_channel) / sizeof(lvds_channel[0])) {
-            printf("fdt_fixup_panel_node set lvds channel: %s\n", lvds_channel[data->lvds_channel]);
-            fdt_fixup_setprop_string(blob, node, "rockchip,output", lvds_channel[data->lvds_channel]);
+            DISPLAY_DBG("fdt_fixup_panel_node set lvds channel: %s\n", lvds_channel[data->lvds_channel]);
+            fdt_fixup_setprop_string(txn, node, "rockchip,output", lvds_channel[data->lvds_channel]);
         }
     }
 
-    fdt_fixup_setprop_u32(blob, node, "prepare-delay-ms", data->delay_prepare);
-    fdt_fixup_setprop_u32(blob, node, "enable-delay-ms", data->delay_enable);
-    fdt_fixup_setprop_u32(blob, node, "disable-delay-ms", data->delay_disable);
-    fdt_fixup_setprop_u32(blob, node, "unprepare-delay-ms", data->delay_unprepare);
-    fdt_fixup_setprop_u32(blob, node, "reset-delay-ms", data->delay_reset);
-    fdt_fixup_setprop_u32(blob, node, "init-delay-ms", data->delay_init);
-    fdt_fixup_setprop_u32(blob, node, "width-mm", data->size_width);
-    fdt_fixup_setprop_u32(blob, node, "height-mm", data->size_height);
+    fdt_fixup_setprop_u32(txn, node, "prepare-delay-ms", data->delay_prepare);
+    fdt_fixup_setprop_u32(txn, node, "enable-delay-ms", data->delay_enable);
+    fdt_fixup_setprop_u32(txn, node, "disable-delay-ms", data->delay_disable);
+    fdt_fixup_setprop_u32(txn, node, "unprepare-delay-ms", data->delay_unprepare);
+    fdt_fixup_setprop_u32(txn, node, "reset-delay-ms", data->delay_reset);
+    fdt_fixup_setprop_u32(txn, node, "init-delay-ms", data->delay_init);
+    fdt_fixup_setprop_u32(txn, node, "width-mm", data->size_width);
+    fdt_fixup_setprop_u32(txn, node, "height-mm", data->size_height);
 }
 
-static int fdt_fixup_display_sub_route(void *blob, const char *name,
+/* lcdparamservice picks the smallest link when edp,link-rate/edp,lanes is auto */
+static void fdt_fixup_edp_link(struct fdt_fixup_txn *txn, int connector, int panel,
+                               const struct display_fixup_data *data)
+{
+    int link_bw;
+
+    if (data->edp_link_rate == EDP_LINK_RATE_RBR) {
+        link_bw = DP_LINK_BW_1_62;
+    } else if (data->edp_link_rate == EDP_LINK_RATE_HBR) {
+        link_bw = DP_LINK_BW_2_7;
+    } else {
+        link_bw = 0;
+    }
+
+    if (link_bw && (data->edp_lanes == 1 || data->edp_lanes == 2 || data->edp_lanes == 4)) {
+        DISPLAY_INFO("fixup edp link: %d Mbps x %d lanes\n", data->edp_link_rate, data->edp_lanes);
+        fdt_fixup_setprop_u32(txn, connector, "rockchip,link-rate", link_bw);
+        fdt_fixup_setprop_u32(txn, connector, "rockchip,lane-count", data->edp_lanes);
+    } else if (data->edp_link_rate || data->edp_lanes) {
+        printf("invalid edp link %d Mbps x %d lanes, keep dts link\n",
+               data->edp_link_rate, data->edp_lanes);
+    }
+
+    if (data->edp_bpc == 6 || data->edp_bpc == 8 || data->edp_bpc == 10) {
+        fdt_fixup_setprop_u32(txn, panel, "bpc", data->edp_bpc);
+    }
+}
+
+static int fdt_fixup_display_sub_route(struct fdt_fixup_txn *txn, const char *name,
                                        enum fdt_status status,
                                        const struct display_fixup_data *data)
 {
+    const void *blob = txn->blob;
     int route, phandle, connect, connector, panel, dt, timing;
     enum fdt_status route_status = status;
     char path[64];
@@ -1449,7 +2383,7 @@ static int fdt_fixup_display_sub_route(void *blob, const char *name,
     }
 
     /* fixup route status */
-    ret = fdt_fixup_node_status(blob, route, route_status);
+    ret = fdt_fixup_node_status(txn, route, route_status);
     if (ret < 0) {
         return ret;
     }
@@ -1459,7 +2393,7 @@ static int fdt_fixup_display_sub_route(void *blob, const char *name,
         return phandle;
     }
 
-    connect = fdt_node_offset_by_phandle(blob, phandle);
+    connect = display_node_offset_by_phandle(blob, phandle);
     if (connect < 0) {
         return connect;
     }
@@ -1469,7 +2403,7 @@ static int fdt_fixup_display_sub_route(void *blob, const char *name,
         return connector;
     }
     /* fixup connector status */
-    ret = fdt_fixup_node_status(blob, connector, status);
+    ret = fdt_fixup_node_status(txn, connector, status);
     if (ret < 0) {
         return ret;
     }
@@ -1480,7 +2414,7 @@ static int fdt_fixup_display_sub_route(void *blob, const char *name,
     }
 
     /* fixup panel status */
-    ret = fdt_fixup_node_status(blob, panel, status);
+    ret = fdt_fixup_node_status(txn, panel, status);
     if (ret < 0) {
         return ret;
     }
@@ -1490,13 +2424,19 @@ static int fdt_fixup_display_sub_route(void *blob, const char *name,
     }
 
     if (!strcmp(name, "dsi0")) {
-        if (data->lane_rate > 100 && data->lane_rate < 2000) { //防止值无效
-            fdt_fixup_setprop_u32(blob, connector, "rockchip,lane-rate", data->lane_rate);
+        /* lcdparamservice computes the lane rate if dsi,lane-rate is auto */
+        if (data->lane_rate >= DSI_LANE_RATE_MIN && data->lane_rate <= DSI_LANE_RATE_MAX) {
+            DISPLAY_INFO("fixup dsi lane rate: %d Mbps\n", data->lane_rate);
+            fdt_fixup_setprop_u32(txn, connector, "rockchip,lane-rate", data->lane_rate);
+        } else {
+            printf("invalid dsi lane rate %d, keep dts lane rate\n", data->lane_rate);
         }
+    } else if (!strcmp(name, "edp")) {
+        fdt_fixup_edp_link(txn, connector, panel, data);
     }
 
     /* fixup panel info */
-    fdt_fixup_panel_node(blob, panel, name, data);
+    fdt_fixup_panel_node(txn, panel, name, data);
 
     dt = fdt_subnode_offset(blob, panel, "display-timings");
     if (dt < 0) {
@@ -1510,39 +2450,45 @@ static int fdt_fixup_display_sub_route(void *blob, const char *name,
             return phandle;
         }
 
-        timing = fdt_node_offset_by_phandle_node(blob, dt, phandle);
+        timing = display_node_offset_by_phandle(blob, phandle);
         if (timing < 0) {
             return timing;
         }
     }
 
     /* fixup panel display timing */
-    fdt_fixup_display_timing(blob, timing, data);
+    fdt_fixup_display_timing(txn, timing, data);
     return 0;
 }
 
 static void fdt_fixup_display_route(void *blob, const struct display_fixup_data *data)
 {
+    struct fdt_fixup_txn txn;
+
+    fdt_fixup_txn_init(&txn, blob);
+
     if (data->type == PANEL_TYPE_DSI) {
-        printf("%s : %d  ======PANEL_TYPE_DSI======== \n", __FUNCTION__, __LINE__);
-        fdt_fixup_display_sub_route(blob, "dsi0", FDT_STATUS_OKAY, data);
-        fdt_fixup_display_sub_route(blob, "edp", FDT_STATUS_DISABLED, data);
-        fdt_fixup_display_sub_route(blob, "lvds", FDT_STATUS_DISABLED, data);
+        DISPLAY_DBG("%s : %d  ======PANEL_TYPE_DSI======== \n", __FUNCTION__, __LINE__);
+        fdt_fixup_display_sub_route(&txn, "dsi0", FDT_STATUS_OKAY, data);
+        fdt_fixup_display_sub_route(&txn, "edp", FDT_STATUS_DISABLED, data);
+        fdt_fixup_display_sub_route(&txn, "lvds", FDT_STATUS_DISABLED, data);
     } else if (data->type == PANEL_TYPE_EDP) {
-        printf("%s : %d  ======PANEL_TYPE_EDP======== \n", __FUNCTION__, __LINE__);
-        fdt_fixup_display_sub_route(blob, "dsi0", FDT_STATUS_DISABLED, data);
-        fdt_fixup_display_sub_route(blob, "edp", FDT_STATUS_OKAY, data);
-        fdt_fixup_display_sub_route(blob, "lvds", FDT_STATUS_DISABLED, data);
+        DISPLAY_DBG("%s : %d  ======PANEL_TYPE_EDP======== \n", __FUNCTION__, __LINE__);
+        fdt_fixup_display_sub_route(&txn, "dsi0", FDT_STATUS_DISABLED, data);
+        fdt_fixup_display_sub_route(&txn, "edp", FDT_STATUS_OKAY, data);
+        fdt_fixup_display_sub_route(&txn, "lvds", FDT_STATUS_DISABLED, data);
     } else if (data->type == PANEL_TYPE_LVDS) {
-        printf("%s : %d  ======PANEL_TYPE_LVDS======== \n", __FUNCTION__, __LINE__);
-        fdt_fixup_display_sub_route(blob, "dsi0", FDT_STATUS_DISABLED, data);
-        fdt_fixup_display_sub_route(blob, "edp", FDT_STATUS_DISABLED, data);
-        fdt_fixup_display_sub_route(blob, "lvds", FDT_STATUS_OKAY, data);
+        DISPLAY_DBG("%s : %d  ======PANEL_TYPE_LVDS======== \n", __FUNCTION__, __LINE__);
+        fdt_fixup_display_sub_route(&txn, "dsi0", FDT_STATUS_DISABLED, data);
+        fdt_fixup_display_sub_route(&txn, "edp", FDT_STATUS_DISABLED, data);
+        fdt_fixup_display_sub_route(&txn, "lvds", FDT_STATUS_OKAY, data);
     } else {
-        fdt_fixup_display_sub_route(blob, "dsi0", FDT_STATUS_DISABLED, data);
-        fdt_fixup_display_sub_route(blob, "edp", FDT_STATUS_DISABLED, data);
-        fdt_fixup_display_sub_route(blob, "lvds", FDT_STATUS_DISABLED, data);
+        fdt_fixup_display_sub_route(&txn, "dsi0", FDT_STATUS_DISABLED, data);
+        fdt_fixup_display_sub_route(&txn, "edp", FDT_STATUS_DISABLED, data);
+        fdt_fixup_display_sub_route(&txn, "lvds", FDT_STATUS_DISABLED, data);
     }
+
+    fdt_fixup_txn_commit(&txn);
 }
 
 int rockchip_display_init(void)
@@ -1555,11 +2501,14 @@ int rockchip_display_init(void)
     const char *name;
     struct public_phy_data *data;
     struct display_fixup_data fixup_data;
+    unsigned long start;
 
-    printf("Rockchip UBOOT DRM driver version: %s\n", DRIVER_VERSION);
+    DISPLAY_INFO("Rockchip UBOOT DRM driver version: %s\n", DRIVER_VERSION);
 
     if (!get_lcdparam_info_from_custom_partition(&fixup_data)) {
+        start = timer_get_us();
         fdt_fixup_display_route((void *)blob, &fixup_data);
+        display_stage_end(DISPLAY_STAGE_DT_FIXUP, start);
     }
 
     route = fdt_path_offset(blob, "/display-subsystem/route");
@@ -1593,7 +2542,7 @@ int rockchip_display_init(void)
             continue;
         }
 
-        connect = fdt_node_offset_by_phandle(blob, phandle);
+        connect = display_node_offset_by_phandle(blob, phandle);
         if (connect < 0) {
             printf("Warn: %s: can't find connect node\n",
                    fdt_get_name(blob, child, NULL));
@@ -1662,8 +2611,10 @@ int rockchip_display_init(void)
         s->crtc_state.crtc_id = get_crtc_id(blob, connect);
         s->node = child;
 
+        start = timer_get_us();
         connector_phy_init(s, data);
         connector_panel_init(s);
+        display_stage_end(DISPLAY_STAGE_PHY_INIT, start);
         list_add_tail(&s->head, &rockchip_display_list);
     }
 
@@ -1678,6 +2629,32 @@ err_free:
     return -ENODEV;
 }
 
+static void fdt_fixup_display_timeline(void *blob)
+{
+    fdt32_t cells[DISPLAY_STAGE_COUNT * 2];
+    char names[DISPLAY_STAGE_COUNT * 16];
+    struct fdt_fixup_txn txn;
+    int chosen, i, len = 0;
+
+    chosen = fdt_path_offset(blob, "/chosen");
+    if (chosen < 0) {
+        return;
+    }
+
+    for (i = 0; i < DISPLAY_STAGE_COUNT; i++) {
+        cells[i * 2] = cpu_to_fdt32(display_timeline[i].start);
+        cells[i * 2 + 1] = cpu_to_fdt32(display_timeline[i].total);
+        strcpy(&names[len], display_stage_names[i]);
+        len += strlen(display_stage_names[i]) + 1;
+        DISPLAY_INFO("display %-15s %7u us\n", display_stage_names[i], display_timeline[i].total);
+    }
+
+    fdt_fixup_txn_init(&txn, blob);
+    fdt_fixup_setprop(&txn, chosen, "rockchip,display-timeline", cells, sizeof(cells));
+    fdt_fixup_setprop(&txn, chosen, "rockchip,display-timeline-names", names, len);
+    fdt_fixup_txn_commit(&txn);
+}
+
 void rockchip_display_fixup(void *blob)
 {
     const struct rockchip_connector_funcs *conn_funcs;
@@ -1690,10 +2667,15 @@ void rockchip_display_fixup(void *blob)
     char path[100];
     int ret;
     struct display_fixup_data fixup_data;
+    struct fdt_fixup_txn txn;
+    unsigned long start;
 
     if (!get_lcdparam_info_from_custom_partition(&fixup_data)) {
+        start = timer_get_us();
         fdt_fixup_display_route(blob, &fixup_data);
+        display_stage_end(DISPLAY_STAGE_KERNEL_FIXUP, start);
     }
+    fdt_fixup_display_timeline(blob);
 
     if (!get_display_size()) {
         return;
@@ -1707,6 +2689,14 @@ void rockchip_display_fixup(void *blob)
         return;
     }
 
+    if (fdt_update_reserved_memory(blob, "rockchip,display-log",
+                                   (u64)(unsigned long)&display_log_ring,
+                                   (u64)sizeof(display_log_ring)) < 0) {
+        printf("failed to add display-log memory\n");
+    }
+    /* the new reserved-memory nodes moved the display nodes */
+    display_phandle_index_drop();
+
     list_for_each_entry(s, &rockchip_display_list, head) {
         conn = s->conn_state.connector;
         if (!conn) {
@@ -1744,8 +2734,15 @@ void rockchip_display_fixup(void *blob)
             continue;
         }
 
+        /* one lookup and one write for all the properties of this route */
+        node = fdt_path_offset(blob, path);
+        if (node < 0) {
+            continue;
+        }
+        fdt_fixup_txn_init(&txn, blob);
+
 #define FDT_SET_U32(name, val) \
-        do_fixup_by_path_u32(blob, path, name, val, 1);
+        fdt_fixup_setprop_u32(&txn, node, name, val);
 
         offset = s->logo.offset + s->logo.mem - memory_start;
         FDT_SET_U32("logo,offset", offset);
@@ -1765,5 +2762,7 @@ void rockchip_display_fixup(void *blob)
         FDT_SET_U32("overscan,top_margin", s->conn_state.overscan.top_margin);
         FDT_SET_U32("overscan,bottom_margin", s->conn_state.overscan.bottom_margin);
 #undef FDT_SET_U32
+
+        fdt_fixup_txn_commit(&txn);
     }
 }
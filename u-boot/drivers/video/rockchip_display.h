@@ -62,12 +62,36 @@ struct crtc_state {
 	bool yuv_overlay;
 };
 
+/*
+ * Power up of a panel, one step at a time. The panel driver's prepare runs
+ * the step in panel_state.step, up to PANEL_STEP_INIT, and never waits the
+ * delays below: the display core waits them between the steps as deadlines
+ * shared by all displays, see display_panel_step().
+ */
+enum panel_step {
+	PANEL_STEP_POWER,	/* supplies, enable gpio, then prepare-delay-ms */
+	PANEL_STEP_RESET,	/* reset pulse, then reset-delay-ms */
+	PANEL_STEP_INIT,	/* init sequence */
+	PANEL_STEP_VIDEO,	/* crtc and connector enable, then enable-delay-ms */
+	PANEL_STEP_ENABLE,	/* panel enable, backlight */
+	PANEL_STEP_DONE,
+};
+
 struct panel_state {
 	int node;
 	int dsp_lut_node;
 
 	const struct rockchip_panel *panel;
 	void *private;
+
+	/* delays of the panel node, read once by connector_panel_init() */
+	int prepare_delay_ms;
+	int reset_delay_ms;
+	int enable_delay_ms;
+
+	enum panel_step step;
+	bool pending;			/* steps left, next not before step_at */
+	unsigned long step_at;
 };
 
 struct overscan {
@@ -137,9 +161,13 @@ struct display_state {
 	int enable;
 	int is_init;
 	int is_enable;
+	bool edid_cached;
+	bool lcdparam_logo;
 };
 
 int drm_mode_vrefresh(const struct drm_display_mode *mode);
+/* call from board init once the storage is up, before the display */
+void rockchip_display_prefetch_lcdparam(void);
 bool drm_mode_is_420(const struct drm_display_info *display,
 		     const struct drm_display_mode *mode);
 
@@ -0,0 +1,109 @@
+/*
+ * (C) Copyright 2008-2016 Fuzhou Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier: GPL-2.0+
+ */
+
+#ifdef USE_HOSTCC
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <libfdt.h>
+
+typedef uint32_t u32;
+#else
+#include <common.h>
+#include <errno.h>
+#include <libfdt.h>
+#include <malloc.h>
+#endif
+
+#include "rockchip_phandle.h"
+
+/*
+ * fdt_node_offset_by_phandle() scans the whole blob on every call. The
+ * index takes one scan to collect every node with a phandle and one
+ * qsort(), each lookup after that is a binary search. The nodes come in
+ * offset order, the phandles in whatever order dtc or the overlays gave
+ * them, so the sort must not depend on them being nearly sorted.
+ */
+static int rockchip_phandle_compare(const void *a, const void *b)
+{
+    const struct rockchip_phandle *pa = a, *pb = b;
+
+    if (pa->phandle == pb->phandle) {
+        return 0;
+    }
+
+    return pa->phandle < pb->phandle ? -1 : 1;
+}
+
+int rockchip_phandle_index_build(struct rockchip_phandle_index *index, const void *blob)
+{
+    struct rockchip_phandle *entries;
+    int node, count = 0, i = 0;
+    u32 phandle;
+
+    rockchip_phandle_index_free(index);
+
+    for (node = fdt_next_node(blob, -1, NULL); node >= 0; node = fdt_next_node(blob, node, NULL)) {
+        if (fdt_get_phandle(blob, node)) {
+            count++;
+        }
+    }
+
+    entries = malloc(sizeof(*entries) * (count ? count : 1));
+    if (!entries) {
+        return -ENOMEM;
+    }
+
+    for (node = fdt_next_node(blob, -1, NULL); node >= 0 && i < count;
+         node = fdt_next_node(blob, node, NULL)) {
+        phandle = fdt_get_phandle(blob, node);
+        if (phandle) {
+            entries[i].phandle = phandle;
+            entries[i].offset = node;
+            i++;
+        }
+    }
+
+    qsort(entries, i, sizeof(*entries), rockchip_phandle_compare);
+
+    index->blob = blob;
+    index->count = i;
+    index->entries = entries;
+
+    return 0;
+}
+
+void rockchip_phandle_index_free(struct rockchip_phandle_index *index)
+{
+    free(index->entries);
+    index->entries = NULL;
+    index->blob = NULL;
+    index->count = 0;
+}
+
+/* node offset of phandle, -FDT_ERR_NOTFOUND like fdt_node_offset_by_phandle() */
+int rockchip_phandle_index_lookup(const struct rockchip_phandle_index *index, u32 phandle)
+{
+    int lo = 0, hi = index->count - 1, mid;
+
+    if (phandle == 0 || phandle == (u32)-1) {
+        return -FDT_ERR_BADPHANDLE;
+    }
+
+    while (lo <= hi) {
+        mid = (lo + hi) / 2;
+        if (index->entries[mid].phandle == phandle) {
+            return index->entries[mid].offset;
+        }
+        if (index->entries[mid].phandle < phandle) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    return -FDT_ERR_NOTFOUND;
+}
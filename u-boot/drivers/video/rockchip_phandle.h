@@ -0,0 +1,31 @@
+/*
+ * (C) Copyright 2008-2016 Fuzhou Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _ROCKCHIP_PHANDLE_H
+#define _ROCKCHIP_PHANDLE_H
+
+/*
+ * phandle to node offset index of one blob, see rockchip_phandle.c.
+ * Plain libfdt, also built on the host with USE_HOSTCC for lcdparambench.
+ */
+struct rockchip_phandle {
+	u32 phandle;
+	int offset;
+};
+
+struct rockchip_phandle_index {
+	const void *blob;
+	int count;
+	struct rockchip_phandle *entries;
+};
+
+int rockchip_phandle_index_build(struct rockchip_phandle_index *index,
+				 const void *blob);
+void rockchip_phandle_index_free(struct rockchip_phandle_index *index);
+int rockchip_phandle_index_lookup(const struct rockchip_phandle_index *index,
+				  u32 phandle);
+
+#endif